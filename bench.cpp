@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/uuid/random_generator.hpp>
+#include <climits>
+#include <memory>
+#include <random>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include "gossip.hpp"
+#ifdef __linux__
+#include "local.hpp"
+#endif
+
+using boost::asio::io_context;
+using boost::asio::ip::address_v4;
+using boost::asio::ip::udp;
+using boost::uuids::basic_random_generator;
+using gossip::Codec;
+using gossip::Gossip;
+using gossip::Member;
+#ifdef __linux__
+using gossip::ShmRing;
+#endif
+using gossip::Spreading;
+using gossip::SteadyClock;
+using gossip::Transport;
+using gossip::message::Ack;
+using gossip::message::Hello;
+using gossip::message::Invalidate;
+using gossip::message::Memberlist;
+using gossip::message::Message;
+using gossip::message::Value;
+using std::make_shared;
+using std::make_unique;
+using std::shared_ptr;
+using std::string;
+using std::type_index;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+/** Swallows every datagram so the send path is measured without a socket. */
+class NullTransport : public Transport {
+public:
+  virtual void receive(const ReceiveFn t_receive) override {}
+  virtual void send(const udp::endpoint &t_destination, const shared_ptr<string> t_data) override {}
+};
+
+vector<Member> make_members(const size_t t_count) {
+  std::mt19937 random(1);
+  basic_random_generator<std::mt19937> uids(random);
+  vector<Member> members;
+  for (size_t i = 0; i < t_count; ++i)
+    members.emplace_back(uids(), udp::endpoint(address_v4(0x0a000001 + i), 7777));
+  return members;
+}
+
+/** A connected node knowing `t_members` peers, with pacing out of the way. */
+class Node {
+  io_context m_timers;
+  vector<Member> m_members;
+  unique_ptr<Gossip> m_gossip;
+
+public:
+  Node(const size_t t_members) : m_members(make_members(t_members + 1)) {
+    m_gossip = make_unique<Gossip>(m_members.front(), [](string) {}, make_shared<NullTransport>(),
+                                   make_shared<SteadyClock>(m_timers));
+    m_gossip->replication_factor() = 0;
+    for (auto &rate : {&m_gossip->pacer().initial_rate(), &m_gossip->pacer().max_rate(),
+                       &m_gossip->pacer().packet_rate(), &m_gossip->pacer().egress_rate()})
+      *rate = INT_MAX;
+    for (size_t i = 1; i < m_members.size(); ++i)
+      m_gossip->insert_member(make_shared<Member>(m_members[i]));
+    m_gossip->add_member(m_members[1]);
+    flush();
+  }
+
+  Gossip &gossip() { return *m_gossip; }
+  const vector<Member> &members() const { return m_members; }
+
+  void flush() {
+    auto &context = m_gossip->context();
+    context.restart();
+    context.poll();
+  }
+};
+
+/** The bytes `Gossip::m_send` would put on the wire for `t_message`. */
+template <typename IMessage>
+string wire(Node &t_node, const IMessage &t_message) {
+  Message::shared_ptr message = make_shared<IMessage>(t_message);
+  return t_node.gossip().codec().encode(gossip::message::to_string(message), type_index(typeid(t_message)),
+                                        Codec::capabilities | Codec::shared_dictionaries);
+}
+
+void BM_SerializeHello(benchmark::State &state) {
+  Message::shared_ptr message = make_shared<Hello>(make_shared<Member>(make_members(1).front()));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(gossip::message::to_string(message));
+}
+BENCHMARK(BM_SerializeHello);
+
+void BM_SerializeValue(benchmark::State &state) {
+  Message::shared_ptr message = make_shared<Value>(1, gossip::Error::NONE, gossip::Cache::Entry{string(64, 'v'), 1});
+  for (auto _ : state)
+    benchmark::DoNotOptimize(gossip::message::to_string(message));
+}
+BENCHMARK(BM_SerializeValue);
+
+void BM_SerializeMemberlist(benchmark::State &state) {
+  Message::shared_ptr message = make_shared<Memberlist>(make_members(state.range(0)));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    auto data = gossip::message::to_string(message);
+    bytes += data.size();
+    benchmark::DoNotOptimize(data);
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_SerializeMemberlist)->RangeMultiplier(10)->Range(10, 10000);
+
+void BM_DecodeAck(benchmark::State &state) {
+  Node node(1);
+  auto sender = node.members()[1];
+  auto data = wire(node, Ack{1});
+  for (auto _ : state)
+    benchmark::DoNotOptimize(node.gossip().deliver(data, sender));
+}
+BENCHMARK(BM_DecodeAck);
+
+void BM_DecodeMemberlist(benchmark::State &state) {
+  // Every member is already known, so receive reduces to the duplicate check.
+  Node node(state.range(0));
+  auto sender = node.members()[1];
+  auto members = node.members();
+  members.erase(members.begin());
+  auto data = wire(node, Memberlist{members});
+  for (auto _ : state)
+    benchmark::DoNotOptimize(node.gossip().deliver(data, sender));
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_DecodeMemberlist)->RangeMultiplier(10)->Range(10, 1000);
+
+void BM_Enqueue(benchmark::State &state) {
+  // Includes the flush, so each iteration covers enqueue, serialization,
+  // compression and pacing up to the transport.
+  Node node(state.range(1));
+  auto spreading = (Spreading)state.range(0);
+  auto target = make_shared<Member>(node.members()[1]);
+  Invalidate message{vector<string>{"key:1"}};
+  for (auto _ : state) {
+    node.gossip().enqueue_message(message, spreading, target);
+    node.flush();
+  }
+}
+BENCHMARK(BM_Enqueue)
+    ->ArgNames({"spreading", "members"})
+    ->ArgsProduct({{(int)Spreading::DIRECT, (int)Spreading::RANDOM, (int)Spreading::BROADCAST},
+                   benchmark::CreateRange(10, 10000, 10)});
+
+void BM_MembershipAdd(benchmark::State &state) {
+  // One join and one removal, each followed by a full rebalance at the default replication factor.
+  Node node(state.range(0));
+  node.gossip().replication_factor() = 2;
+  auto member = make_shared<Member>(make_members(state.range(0) + 2).back());
+  for (auto _ : state) {
+    node.gossip().insert_member(member);
+    node.gossip().erase_member(member);
+  }
+}
+BENCHMARK(BM_MembershipAdd)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMillisecond);
+
+void BM_MembershipLookup(benchmark::State &state) {
+  // Inserting a known member is the duplicate check every gossiped Memberlist entry goes through.
+  Node node(state.range(0));
+  auto member = make_shared<Member>(node.members().back());
+  for (auto _ : state)
+    benchmark::DoNotOptimize(node.gossip().insert_member(member));
+}
+BENCHMARK(BM_MembershipLookup)->RangeMultiplier(10)->Range(10, 10000);
+
+void BM_MembershipSample(benchmark::State &state) {
+  Node node(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(node.gossip().peers(node.gossip().fanout()));
+}
+BENCHMARK(BM_MembershipSample)->RangeMultiplier(10)->Range(10, 10000);
+
+#ifdef __linux__
+void BM_ShmRingRoundTrip(benchmark::State &state) {
+  const size_t capacity = 1 << 20;
+  vector<char> region(ShmRing::size_of(capacity) + 64);
+  ShmRing ring(region.data() + (64 - (uintptr_t)region.data() % 64) % 64, capacity, true);
+  string frame(state.range(0), 'v');
+  size_t bytes = 0;
+  for (auto _ : state) {
+    ring.push(frame);
+    ring.poll([&bytes](const std::string_view t_frame) { bytes += t_frame.size(); });
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_ShmRingRoundTrip)->RangeMultiplier(8)->Range(64, 65536);
+#endif
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+  // JSON unless the caller asked for another format.
+  vector<char *> args(argv, argv + argc);
+  string json = "--benchmark_format=json";
+  if (std::none_of(args.begin(), args.end(), [](const char *arg) {
+        return string(arg).starts_with("--benchmark_format");
+      }))
+    args.push_back(json.data());
+
+  int count = args.size();
+  benchmark::Initialize(&count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
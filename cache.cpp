@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <string>
+
+#include "cache.hpp"
+
+using std::make_unique;
+using std::max;
+using std::string;
+
+namespace gossip {
+
+uint64_t hash(const string &t_data, const uint64_t t_seed) {
+  uint64_t hash = t_seed;
+  for (const unsigned char c : t_data) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+Cache::Entry::Entry(const string t_value, const uint64_t t_version, const uuid t_writer)
+    : value(t_value),
+      version(t_version),
+      writer(t_writer) {}
+
+bool Cache::Entry::supersedes(const Entry &t_entry) const {
+  return version != t_entry.version ? version > t_entry.version : writer > t_entry.writer;
+}
+
+uint64_t Cache::Entry::stamp() const {
+  if (version == 0)
+    return 0;
+  return hash(string(writer.begin(), writer.end()), version);
+}
+
+Cache::Cache(const uuid t_writer)
+    : m_partitions(partition_count),
+      m_trees(partition_count),
+      m_writer(t_writer) {}
+
+uint32_t Cache::partition_of(const string &t_key) { return hash(t_key) % partition_count; }
+
+optional<Cache::Entry> Cache::get(const string &t_key) const {
+  const Partition &partition = m_partitions[partition_of(t_key)];
+  auto it = partition.find(t_key);
+  if (it == partition.end())
+    return {};
+
+  return it->second;
+}
+
+const Cache::Entry &Cache::set(const string &t_key, const string &t_value) {
+  uint32_t partition = partition_of(t_key);
+  Entry &entry = m_partitions[partition][t_key];
+  uint64_t before = entry.stamp();
+  entry = Entry{t_value, ++m_clock, m_writer};
+  m_tree(partition).update(t_key, before, entry.stamp());
+  return entry;
+}
+
+bool Cache::apply(const string &t_key, const Entry &t_entry) {
+  m_clock = max(m_clock, t_entry.version);
+
+  uint32_t partition = partition_of(t_key);
+  Entry &entry = m_partitions[partition][t_key];
+  if (!t_entry.supersedes(entry))
+    return false;
+
+  m_tree(partition).update(t_key, entry.stamp(), t_entry.stamp());
+  entry = t_entry;
+  return true;
+}
+
+Cache::Range Cache::scan(const uint32_t t_partition,
+                         const optional<string> &t_after,
+                         const size_t t_max_bytes) const {
+  const Partition &partition = m_partitions[t_partition];
+  auto it = t_after ? partition.upper_bound(*t_after) : partition.begin();
+
+  Range range;
+  size_t bytes = 0;
+  for (; it != partition.end() && bytes < t_max_bytes; ++it) {
+    bytes += it->first.size() + it->second.value.size() + sizeof(uint64_t) + sizeof(uuid);
+    range.emplace_back(*it);
+  }
+
+  return range;
+}
+
+Cache::Range Cache::leaf(const uint32_t t_partition, const uint32_t t_leaf) const {
+  Range range;
+  for (const auto &item : m_partitions[t_partition]) {
+    if (Merkle::leaf_of(item.first) == t_leaf)
+      range.emplace_back(item);
+  }
+
+  return range;
+}
+
+size_t Cache::drop(const uint32_t t_partition) {
+  size_t dropped = m_partitions[t_partition].size();
+  m_partitions[t_partition].clear();
+  m_trees[t_partition].reset();
+  return dropped;
+}
+
+const Cache::Partition &Cache::partition(const uint32_t t_partition) const { return m_partitions[t_partition]; }
+const Merkle &Cache::tree(const uint32_t t_partition) const {
+  static const Merkle empty;
+  return m_trees[t_partition] ? *m_trees[t_partition] : empty;
+}
+
+Merkle &Cache::m_tree(const uint32_t t_partition) {
+  auto &tree = m_trees[t_partition];
+  if (!tree)
+    tree = make_unique<Merkle>();
+  return *tree;
+}
+
+size_t Cache::size() const {
+  size_t size = 0;
+  for (const auto &partition : m_partitions)
+    size += partition.size();
+  return size;
+}
+
+}; // namespace gossip
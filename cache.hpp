@@ -0,0 +1,107 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_serialize.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "merkle.hpp"
+
+using boost::uuids::uuid;
+using std::map;
+using std::optional;
+using std::pair;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace gossip {
+
+/** Stable 64-bit FNV-1a hash, identical on every member regardless of the standard library. */
+uint64_t hash(const string &t_data, const uint64_t t_seed = 0xcbf29ce484222325ULL);
+
+class Cache {
+public:
+  class Entry {
+    friend class boost::serialization::access;
+    template <class Archive>
+    void serialize(Archive &ar, const unsigned int version) {
+      ar &value;
+      ar &this->version;
+      if (version >= 1)
+        ar &writer;
+    }
+
+  public:
+    string value;
+    uint64_t version = 0;
+    /** The member that wrote this version; breaks ties between equal versions written on different members. */
+    uuid writer{};
+
+    Entry() = default;
+    Entry(const string t_value, const uint64_t t_version, const uuid t_writer = {});
+
+    /** Whether this entry wins over `t_entry`: the higher version, then the higher writer. */
+    bool supersedes(const Entry &t_entry) const;
+    /** What the Merkle tree hashes for this entry; 0 when absent. */
+    uint64_t stamp() const;
+  };
+
+  using Partition = map<string, Entry>;
+  using Range = vector<pair<string, Entry>>;
+
+  /** The fixed number of partitions the key space is split into. */
+  static const uint32_t partition_count = 1024;
+
+  Cache(const uuid t_writer = {});
+
+  static uint32_t partition_of(const string &t_key);
+
+  optional<Entry> get(const string &t_key) const;
+  const Entry &set(const string &t_key, const string &t_value);
+
+  /** Applies a replicated entry, keeping whichever one supersedes the other. */
+  bool apply(const string &t_key, const Entry &t_entry);
+
+  /** Returns up to `t_max_bytes` of entries of a partition whose keys sort after `t_after`. */
+  Range scan(const uint32_t t_partition,
+             const optional<string> &t_after,
+             const size_t t_max_bytes) const;
+
+  /** Returns every entry of a partition that hashes into the given Merkle leaf. */
+  Range leaf(const uint32_t t_partition, const uint32_t t_leaf) const;
+
+  /** Discards a partition this member no longer holds; returns how many entries went with it. */
+  size_t drop(const uint32_t t_partition);
+
+  const Partition &partition(const uint32_t t_partition) const;
+  const Merkle &tree(const uint32_t t_partition) const;
+  size_t size() const;
+
+private:
+  vector<Partition> m_partitions;
+  // Allocated on a partition's first write; most members own few of the
+  // partitions and a full set of trees is ~1 MiB.
+  vector<unique_ptr<Merkle>> m_trees;
+  uint64_t m_clock = 0;
+  uuid m_writer;
+
+  Merkle &m_tree(const uint32_t t_partition);
+};
+
+}; // namespace gossip
+
+BOOST_CLASS_VERSION(gossip::Cache::Entry, 1);
+
+#endif
@@ -0,0 +1,219 @@
+#include <boost/asio.hpp>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "client.hpp"
+
+using boost::asio::co_spawn;
+using boost::asio::detached;
+using boost::asio::post;
+using std::lock_guard;
+using std::make_shared;
+using std::make_unique;
+using std::mutex;
+using std::promise;
+using std::chrono::milliseconds;
+
+namespace gossip {
+
+Client::Client(const Member t_self,
+               const vector<Member> t_seeds,
+               const size_t t_near_cache_capacity,
+               const ConfigureFn t_configure)
+    : m_gossip(make_unique<Gossip>(t_self, [](string) {})),
+      m_near_cache(t_near_cache_capacity > 0),
+      m_hits(m_gossip->metrics().counter("client_near_cache_hits_total", "Client reads answered from local memory")),
+      m_misses(m_gossip->metrics().counter("client_near_cache_misses_total", "Client reads passed to the member")) {
+  for (auto &shard : m_shards)
+    shard.cache = NearCache(std::max<size_t>(1, t_near_cache_capacity / shard_count));
+
+  // Owners this member serves must invalidate too; the listener is installed last so it cannot be replaced.
+  m_gossip->invalidate_reads() = true;
+  if (t_configure)
+    t_configure(*m_gossip);
+  m_gossip->invalidation_listener() = [this](const string t_key) { m_invalidate(t_key); };
+  m_near_cache_ttl = milliseconds(m_gossip->near_cache_ttl());
+
+  for (const auto &seed : t_seeds)
+    m_gossip->add_member(seed);
+  m_thread = std::thread([this]() { m_gossip->run(); });
+}
+
+Client::~Client() {
+  post(m_gossip->context(), [this]() { m_gossip->stop(); });
+  m_thread.join();
+}
+
+Client::Shard &Client::m_shard(const string &t_key) { return m_shards[std::hash<string>{}(t_key) % shard_count]; }
+
+uint64_t Client::m_generation(const string &t_key) {
+  auto &shard = m_shard(t_key);
+  lock_guard<mutex> lock(shard.mutex);
+  return shard.generation;
+}
+
+void Client::m_fill(const string &t_key, const uint64_t t_generation, const optional<Cache::Entry> &t_entry) {
+  if (!m_near_cache || !t_entry)
+    return;
+
+  auto &shard = m_shard(t_key);
+  lock_guard<mutex> lock(shard.mutex);
+  if (shard.generation == t_generation) {
+    auto now = steady_clock::now();
+    shard.cache.put(t_key, *t_entry, now + m_near_cache_ttl, now);
+  }
+}
+
+void Client::m_invalidate(const string &t_key) {
+  if (!m_near_cache)
+    return;
+
+  auto &shard = m_shard(t_key);
+  lock_guard<mutex> lock(shard.mutex);
+  shard.cache.erase(t_key);
+  ++shard.generation;
+}
+
+optional<Cache::Entry> Client::m_lookup(const string &t_key, uint64_t &t_generation) {
+  auto &shard = m_shard(t_key);
+  optional<Cache::Entry> entry;
+  {
+    lock_guard<mutex> lock(shard.mutex);
+    entry = shard.cache.get(t_key, steady_clock::now());
+    t_generation = shard.generation;
+  }
+
+  if (entry)
+    m_hits.add();
+  return entry;
+}
+
+void Client::get(const string t_key, const ValueFn t_callback) {
+  uint64_t generation = 0;
+  if (m_near_cache) {
+    if (auto entry = m_lookup(t_key, generation)) {
+      post(m_gossip->context(), [t_callback, value = entry->value]() { t_callback(Error::NONE, value); });
+      return;
+    }
+    m_misses.add();
+  }
+
+  co_spawn(m_gossip->context(), m_get(t_key, generation, t_callback), detached);
+}
+
+optional<string> Client::peek(const string t_key) {
+  // A miss is not counted here; the read that usually follows counts it.
+  uint64_t generation = 0;
+  if (!m_near_cache)
+    return {};
+  auto entry = m_lookup(t_key, generation);
+  return entry ? optional<string>(entry->value) : std::nullopt;
+}
+
+awaitable<void> Client::m_get(const string t_key, const uint64_t t_generation, const ValueFn t_callback) {
+  auto [error, entry] = co_await m_gossip->async_get(t_key);
+  if (error == Error::NONE)
+    m_fill(t_key, t_generation, entry);
+  t_callback(error, entry ? optional<string>(entry->value) : std::nullopt);
+}
+
+void Client::set(const string t_key, const string t_value, const ValueFn t_callback) {
+  co_spawn(m_gossip->context(), m_set(t_key, t_value, t_callback), detached);
+}
+
+awaitable<void> Client::m_set(const string t_key, const string t_value, const ValueFn t_callback) {
+  // `Gossip::set` reports its own write to the listener exactly once before
+  // returning, so the copy is only kept if nothing else touched the shard.
+  auto generation = m_generation(t_key) + 1;
+  auto [error, entry] = co_await m_gossip->async_set(t_key, t_value);
+  if (error == Error::NONE)
+    m_fill(t_key, generation, entry);
+  t_callback(error, entry ? optional<string>(entry->value) : std::nullopt);
+}
+
+future<optional<string>> Client::get(const string t_key) {
+  auto result = make_shared<promise<optional<string>>>();
+  if (auto value = peek(t_key)) {
+    result->set_value(value);
+    return result->get_future();
+  }
+
+  get(t_key, [result](const Error t_error, const optional<string> t_value) {
+    result->set_value(t_error == Error::NONE ? t_value : std::nullopt);
+  });
+  return result->get_future();
+}
+
+future<Error> Client::set(const string t_key, const string t_value) {
+  auto result = make_shared<promise<Error>>();
+  set(t_key, t_value, [result](const Error t_error, const optional<string>) { result->set_value(t_error); });
+  return result->get_future();
+}
+
+future<vector<optional<string>>> Client::mget(const vector<string> t_keys) {
+  auto result = make_shared<promise<vector<optional<string>>>>();
+  co_spawn(
+      m_gossip->context(),
+      [this, t_keys, result]() -> awaitable<void> {
+        vector<optional<string>> values;
+        for (const auto &[error, entry] : co_await m_gossip->async_mget(t_keys))
+          values.push_back(error == Error::NONE && entry ? optional<string>(entry->value) : std::nullopt);
+        result->set_value(values);
+      },
+      detached);
+  return result->get_future();
+}
+
+template <class T> future<T> Client::m_crdts(const std::function<T(Crdts &)> t_fn) {
+  auto result = make_shared<promise<T>>();
+  post(m_gossip->context(), [this, t_fn, result]() {
+    if constexpr (std::is_void_v<T>) {
+      t_fn(m_gossip->crdts());
+      result->set_value();
+    } else {
+      result->set_value(t_fn(m_gossip->crdts()));
+    }
+  });
+  return result->get_future();
+}
+
+future<int64_t> Client::increment(const string t_key, const int64_t t_delta) {
+  return m_crdts<int64_t>([t_key, t_delta](Crdts &crdts) { return crdts.increment(t_key, t_delta); });
+}
+
+future<int64_t> Client::counter(const string t_key) {
+  return m_crdts<int64_t>([t_key](Crdts &crdts) { return crdts.counter(t_key); });
+}
+
+future<void> Client::assign(const string t_key, const string t_value) {
+  return m_crdts<void>([t_key, t_value](Crdts &crdts) { crdts.assign(t_key, t_value); });
+}
+
+future<optional<string>> Client::value(const string t_key) {
+  return m_crdts<optional<string>>([t_key](Crdts &crdts) { return crdts.value(t_key); });
+}
+
+future<void> Client::add(const string t_key, const string t_element) {
+  return m_crdts<void>([t_key, t_element](Crdts &crdts) { crdts.add(t_key, t_element); });
+}
+
+future<void> Client::remove(const string t_key, const string t_element) {
+  return m_crdts<void>([t_key, t_element](Crdts &crdts) { crdts.remove(t_key, t_element); });
+}
+
+future<bool> Client::contains(const string t_key, const string t_element) {
+  return m_crdts<bool>([t_key, t_element](Crdts &crdts) { return crdts.contains(t_key, t_element); });
+}
+
+future<vector<string>> Client::elements(const string t_key) {
+  return m_crdts<vector<string>>([t_key](Crdts &crdts) { return crdts.elements(t_key); });
+}
+
+Metrics &Client::metrics() { return m_gossip->metrics(); }
+
+}; // namespace gossip
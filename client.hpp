@@ -0,0 +1,126 @@
+#ifndef CLIENT_HPP
+#define CLIENT_HPP
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gossip.hpp"
+
+using std::array;
+using std::future;
+using std::optional;
+using std::string;
+using std::vector;
+
+namespace gossip {
+
+/**
+ * The entry point for applications linking the library. A Client runs an
+ * embedded cluster member on its own thread and may be called from any thread;
+ * results arrive through futures or callbacks, and callbacks run on the
+ * member's thread.
+ *
+ * With a near cache, values read or written through the client are kept in
+ * local memory for `near_cache_ttl` and a repeat read is answered without a
+ * request leaving the node; its callback is still posted to the member's
+ * thread, while `peek` answers on the caller's. A copy is dropped as soon as
+ * the member hears the key was written, so it stays coherent as long as every
+ * member runs with `invalidate_reads`; otherwise only hot keys are
+ * invalidated and the TTL bounds staleness.
+ */
+class Client {
+public:
+  typedef std::function<void(Gossip &)> ConfigureFn;
+  typedef std::function<void(const Error, const optional<string>)> ValueFn;
+
+private:
+  static const size_t shard_count = 16;
+
+  /** One slice of the near cache. `generation` moves on every invalidation, so a reply that raced one is not cached. */
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    NearCache cache;
+    uint64_t generation = 0;
+  };
+
+  unique_ptr<Gossip> m_gossip;
+  array<Shard, shard_count> m_shards;
+  bool m_near_cache;
+  std::chrono::milliseconds m_near_cache_ttl;
+  Counter &m_hits;
+  Counter &m_misses;
+  std::thread m_thread;
+
+  Shard &m_shard(const string &t_key);
+  uint64_t m_generation(const string &t_key);
+  /** Looks `t_key` up in its shard and counts a hit; `t_generation` receives the shard's generation either way. */
+  optional<Cache::Entry> m_lookup(const string &t_key, uint64_t &t_generation);
+  void m_fill(const string &t_key, const uint64_t t_generation, const optional<Cache::Entry> &t_entry);
+  void m_invalidate(const string &t_key);
+  awaitable<void> m_get(const string t_key, const uint64_t t_generation, const ValueFn t_callback);
+  awaitable<void> m_set(const string t_key, const string t_value, const ValueFn t_callback);
+
+  /** Runs `t_fn` on the member's thread, where the CRDTs may be touched, and hands back its result. */
+  template <class T> future<T> m_crdts(const std::function<T(Crdts &)> t_fn);
+
+public:
+  /**
+   * Starts a member at `t_self` that joins through `t_seeds`. `t_configure`
+   * runs before the member starts, which is the only time the Gossip may be
+   * touched directly. A near cache capacity of 0 turns the near cache off.
+   * With `owner()` cleared on `t_self` the member owns no partitions and sends
+   * every request to the members that do, so it can come and go freely.
+   */
+  Client(const Member t_self,
+         const vector<Member> t_seeds,
+         const size_t t_near_cache_capacity = 4096,
+         const ConfigureFn t_configure = nullptr);
+  ~Client();
+
+  Client(const Client &) = delete;
+  Client &operator=(const Client &) = delete;
+
+  void get(const string t_key, const ValueFn t_callback);
+  void set(const string t_key, const string t_value, const ValueFn t_callback);
+
+  future<optional<string>> get(const string t_key);
+  future<Error> set(const string t_key, const string t_value);
+
+  /** Returns `t_key` from the near cache on the calling thread, or nothing when it is not held there. */
+  optional<string> peek(const string t_key);
+
+  /** Reads many keys; results keep the order of `t_keys` and missing or failed keys are empty. */
+  future<vector<optional<string>>> mget(const vector<string> t_keys);
+
+  /**
+   * Adds to a counter replicated on every member without a round trip; the
+   * result is this member's view, which other members reach within a few ticks.
+   */
+  future<int64_t> increment(const string t_key, const int64_t t_delta = 1);
+  future<int64_t> counter(const string t_key);
+
+  /** Writes a register replicated like the counters; the latest write wins. */
+  future<void> assign(const string t_key, const string t_value);
+  future<optional<string>> value(const string t_key);
+
+  /** Changes a set replicated like the counters; an add concurrent with a remove of the same element wins. */
+  future<void> add(const string t_key, const string t_element);
+  future<void> remove(const string t_key, const string t_element);
+  future<bool> contains(const string t_key, const string t_element);
+  future<vector<string>> elements(const string t_key);
+
+  /** The member's metrics, including the near cache hit and miss counters. */
+  Metrics &metrics();
+};
+
+}; // namespace gossip
+
+#endif
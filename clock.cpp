@@ -0,0 +1,24 @@
+#include <boost/asio.hpp>
+#include <memory>
+
+#include "clock.hpp"
+
+using boost::asio::steady_timer;
+using boost::system::error_code;
+using std::make_shared;
+
+namespace gossip {
+
+SteadyClock::SteadyClock(io_context &t_context) : m_context(t_context) {}
+
+steady_clock::time_point SteadyClock::now() const { return steady_clock::now(); }
+
+void SteadyClock::schedule(const steady_clock::time_point t_at, const TimerFn t_callback) {
+  auto timer = make_shared<steady_timer>(m_context, t_at);
+  timer->async_wait([timer, t_callback](const error_code ec) {
+    if (!ec)
+      t_callback();
+  });
+}
+
+}; // namespace gossip
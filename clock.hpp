@@ -0,0 +1,42 @@
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
+
+using boost::asio::io_context;
+using std::chrono::steady_clock;
+
+namespace gossip {
+
+/**
+ * The time source of a Gossip node. Every deadline and timer goes through it,
+ * so a simulation can run many nodes under virtual time.
+ */
+class Clock {
+public:
+  typedef std::function<void()> TimerFn;
+
+  virtual ~Clock() = default;
+
+  virtual steady_clock::time_point now() const = 0;
+
+  /** Runs `t_callback` on the node's event loop once `now()` reaches `t_at`. */
+  virtual void schedule(const steady_clock::time_point t_at, const TimerFn t_callback) = 0;
+};
+
+/** Wall-clock time with timers on an io_context. */
+class SteadyClock : public Clock {
+  io_context &m_context;
+
+public:
+  SteadyClock(io_context &t_context);
+
+  virtual steady_clock::time_point now() const override;
+  virtual void schedule(const steady_clock::time_point t_at, const TimerFn t_callback) override;
+};
+
+}; // namespace gossip
+
+#endif
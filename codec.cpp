@@ -0,0 +1,102 @@
+#include <string>
+#include <zlib.h>
+
+#include "codec.hpp"
+
+using std::string;
+
+namespace gossip {
+namespace {
+
+const size_t frame_prefix_size = 2;
+const size_t max_decoded_size = 64 << 20;
+
+} // namespace
+
+void Codec::train(const type_index t_type, const string &t_sample) {
+  uint32_t id = adler32(adler32(0L, Z_NULL, 0), (const Bytef *)t_sample.data(), t_sample.size());
+  m_dictionaries[id] = t_sample;
+  m_types.insert_or_assign(t_type, id);
+  m_dictionary_set = crc32(m_dictionary_set, (const Bytef *)t_sample.data(), t_sample.size());
+}
+
+string Codec::encode(const string &t_data, const type_index t_type, const uint32_t t_capabilities) const {
+  if (!(t_capabilities & (1 << (uint32_t)Compression::DEFLATE)) || t_data.size() < m_threshold)
+    return t_data;
+
+  z_stream stream{};
+  if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+    return t_data;
+
+  // Without a shared dictionary set the peer might hold different bytes under the same id.
+  auto type = m_types.find(t_type);
+  if (type != m_types.end() && (t_capabilities & shared_dictionaries)) {
+    const string &dictionary = m_dictionaries.at(type->second);
+    deflateSetDictionary(&stream, (const Bytef *)dictionary.data(), dictionary.size());
+  }
+
+  string frame(frame_prefix_size + deflateBound(&stream, t_data.size()), '\0');
+  frame[1] = (char)Compression::DEFLATE;
+  stream.next_in = (Bytef *)t_data.data();
+  stream.avail_in = t_data.size();
+  stream.next_out = (Bytef *)&frame[frame_prefix_size];
+  stream.avail_out = frame.size() - frame_prefix_size;
+  int result = deflate(&stream, Z_FINISH);
+  frame.resize(frame_prefix_size + stream.total_out);
+  deflateEnd(&stream);
+
+  if (result != Z_STREAM_END || frame.size() >= t_data.size())
+    return t_data;
+  return frame;
+}
+
+optional<string> Codec::decode(const string &t_frame) const {
+  if (t_frame.empty() || t_frame[0] != '\0')
+    return t_frame;
+
+  if (t_frame.size() < frame_prefix_size || (Compression)t_frame[1] != Compression::DEFLATE)
+    return {};
+
+  z_stream stream{};
+  if (inflateInit(&stream) != Z_OK)
+    return {};
+
+  stream.next_in = (Bytef *)&t_frame[frame_prefix_size];
+  stream.avail_in = t_frame.size() - frame_prefix_size;
+
+  string data;
+  char buffer[16384];
+  int result = Z_OK;
+  while (result != Z_STREAM_END) {
+    stream.next_out = (Bytef *)buffer;
+    stream.avail_out = sizeof(buffer);
+    result = inflate(&stream, Z_NO_FLUSH);
+
+    if (result == Z_NEED_DICT) {
+      auto dictionary = m_dictionaries.find(stream.adler);
+      if (dictionary == m_dictionaries.end())
+        break;
+      inflateSetDictionary(&stream, (const Bytef *)dictionary->second.data(), dictionary->second.size());
+      result = inflate(&stream, Z_NO_FLUSH);
+    }
+
+    if (result != Z_OK && result != Z_STREAM_END)
+      break;
+
+    data.append(buffer, sizeof(buffer) - stream.avail_out);
+    if (data.size() > max_decoded_size)
+      break;
+  }
+  inflateEnd(&stream);
+
+  if (result != Z_STREAM_END)
+    return {};
+  return data;
+}
+
+uint32_t Codec::dictionaries() const { return m_dictionary_set; }
+
+size_t &Codec::threshold() { return m_threshold; }
+const size_t &Codec::threshold() const { return m_threshold; }
+
+}; // namespace gossip
@@ -0,0 +1,62 @@
+#ifndef CODEC_HPP
+#define CODEC_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <typeindex>
+
+using std::map;
+using std::optional;
+using std::string;
+using std::type_index;
+
+namespace gossip {
+
+enum class Compression : uint8_t {
+  NONE = 0,
+  DEFLATE = 1
+};
+
+/**
+ * Optional payload compression for the message codec. A compressed frame is
+ * "\0" + Compression + the deflate stream; serialized text archives never start
+ * with "\0", so compressed and plain frames coexist and plain frames stay
+ * readable by members that never advertised the capability. Each message type
+ * may have a preset dictionary; its zlib id travels inside the stream. The
+ * dictionaries are built from this build's archive bytes, so they are used only
+ * toward peers that advertised the same dictionary set.
+ */
+class Codec {
+  map<uint32_t, string> m_dictionaries;
+  map<type_index, uint32_t> m_types;
+  uint32_t m_dictionary_set = 0;
+  size_t m_threshold = 128;
+
+public:
+  /** The Compression bits this build can decode, advertised in Hello and Welcome. */
+  static const uint32_t capabilities = 1 << (uint32_t)Compression::DEFLATE;
+  /** Never advertised: set locally for a peer whose dictionary set matches ours. */
+  static const uint32_t shared_dictionaries = 1u << 31;
+
+  /** Registers representative bytes of a message type as its preset dictionary. */
+  void train(const type_index t_type, const string &t_sample);
+
+  /** Compresses `t_data` when the peer supports it and it is worth it, otherwise returns it unchanged. */
+  string encode(const string &t_data, const type_index t_type, const uint32_t t_capabilities) const;
+
+  /** Returns the plain serialized message, or nothing when the frame cannot be decoded. */
+  optional<string> decode(const string &t_frame) const;
+
+  /** Identifies the trained dictionaries; 0 before any training. */
+  uint32_t dictionaries() const;
+
+  /** The minimum serialized size in bytes before compression is attempted. */
+  size_t &threshold();
+  const size_t &threshold() const;
+};
+
+}; // namespace gossip
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef COMPLETION_HPP
+#define COMPLETION_HPP
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+using std::unique_ptr;
+
+namespace gossip {
+
+/**
+ * A move-only callback that runs at most once. Unlike std::function it can own
+ * a move-only target such as an asio completion handler, so a suspended
+ * coroutine is parked in it directly; it stands in for
+ * `asio::any_completion_handler`, which this Boost predates.
+ */
+template <typename... Args>
+class Completion {
+  struct Base {
+    virtual ~Base() = default;
+    virtual void call(Args... t_args) = 0;
+  };
+
+  template <typename Fn>
+  struct Target : Base {
+    Fn fn;
+
+    explicit Target(Fn &&t_fn) : fn(std::move(t_fn)) {}
+    void call(Args... t_args) override { std::move(fn)(std::forward<Args>(t_args)...); }
+  };
+
+  unique_ptr<Base> m_target;
+
+public:
+  Completion() = default;
+  Completion(std::nullptr_t) {}
+
+  template <typename Fn,
+            typename = std::enable_if_t<!std::is_same_v<std::decay_t<Fn>, Completion> &&
+                                        !std::is_same_v<std::decay_t<Fn>, std::nullptr_t>>>
+  Completion(Fn t_fn) : m_target(std::make_unique<Target<Fn>>(std::move(t_fn))) {}
+
+  Completion(Completion &&) = default;
+  Completion &operator=(Completion &&) = default;
+
+  explicit operator bool() const { return m_target != nullptr; }
+
+  /** Runs the target and leaves this empty; the target may replace or destroy whatever holds it. */
+  void operator()(Args... t_args) {
+    auto target = std::move(m_target);
+    target->call(std::forward<Args>(t_args)...);
+  }
+};
+
+}; // namespace gossip
+
+#endif
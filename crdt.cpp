@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <boost/container_hash/hash.hpp>
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "crdt.hpp"
+
+using boost::hash_combine;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::system_clock;
+
+namespace gossip {
+
+PNCounter PNCounter::add(const uuid &t_uid, const int64_t t_delta) {
+  auto &slot = m_slots[t_uid];
+  if (t_delta >= 0)
+    slot.first += t_delta;
+  else
+    slot.second += -(uint64_t)t_delta;
+
+  PNCounter delta;
+  delta.m_slots.emplace(t_uid, slot);
+  return delta;
+}
+
+int64_t PNCounter::value() const {
+  uint64_t value = 0;
+  for (const auto &[uid, slot] : m_slots)
+    value += slot.first - slot.second;
+  return (int64_t)value;
+}
+
+bool PNCounter::merge(const PNCounter &t_other) {
+  bool changed = false;
+  for (const auto &[uid, theirs] : t_other.m_slots) {
+    auto &ours = m_slots[uid];
+    if (theirs.first > ours.first || theirs.second > ours.second) {
+      ours = {std::max(ours.first, theirs.first), std::max(ours.second, theirs.second)};
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+uint64_t PNCounter::hash() const {
+  // Slots are unordered, so their hashes are summed; a slot never written is the same as a missing one.
+  uint64_t hash = 0;
+  for (const auto &[uid, slot] : m_slots) {
+    if (!slot.first && !slot.second)
+      continue;
+    size_t seed = boost::hash<uuid>()(uid);
+    hash_combine(seed, slot.first);
+    hash_combine(seed, slot.second);
+    hash += seed;
+  }
+  return hash;
+}
+
+LWWRegister LWWRegister::assign(const uuid &t_uid, const string &t_value, const uint64_t t_time) {
+  m_value = t_value;
+  m_time = std::max(t_time, m_time + 1);
+  m_uid = t_uid;
+  return *this;
+}
+
+optional<string> LWWRegister::value() const { return m_time ? optional<string>(m_value) : std::nullopt; }
+
+bool LWWRegister::merge(const LWWRegister &t_other) {
+  if (std::tie(t_other.m_time, t_other.m_uid) <= std::tie(m_time, m_uid))
+    return false;
+
+  *this = t_other;
+  return true;
+}
+
+uint64_t LWWRegister::hash() const {
+  size_t seed = 0;
+  hash_combine(seed, m_value);
+  hash_combine(seed, m_time);
+  hash_combine(seed, m_uid);
+  return seed;
+}
+
+bool ORSet::m_seen(const Dot &t_dot) const {
+  if (m_forgotten.count(t_dot.first))
+    return true;
+  auto compact = m_compact.find(t_dot.first);
+  return (compact != m_compact.end() && compact->second >= t_dot.second) || m_cloud.count(t_dot);
+}
+
+void ORSet::m_insert(const Dot &t_dot) {
+  if (m_seen(t_dot))
+    return;
+  m_cloud.insert(t_dot);
+  m_fold(t_dot.first);
+}
+
+void ORSet::m_fold(const uuid &t_uid) {
+  // Dots at or below the maximum are redundant, and the ones closing the gap above it extend it.
+  auto &compact = m_compact[t_uid];
+  auto it = m_cloud.erase(m_cloud.lower_bound({t_uid, 0}), m_cloud.upper_bound({t_uid, compact}));
+  for (; it != m_cloud.end() && *it == Dot{t_uid, compact + 1}; it = m_cloud.erase(it))
+    ++compact;
+}
+
+ORSet ORSet::add(const uuid &t_uid, const string &t_element) {
+  ORSet delta;
+  Dot dot{t_uid, m_compact[t_uid] + 1};
+
+  auto &dots = m_entries[t_element];
+  for (const auto &old : dots)
+    delta.m_insert(old);
+  dots = {dot};
+  m_insert(dot);
+
+  delta.m_entries[t_element] = {dot};
+  delta.m_insert(dot);
+  return delta;
+}
+
+ORSet ORSet::remove(const string &t_element) {
+  ORSet delta;
+  auto entry = m_entries.find(t_element);
+  if (entry == m_entries.end())
+    return delta;
+
+  for (const auto &dot : entry->second)
+    delta.m_insert(dot);
+  m_entries.erase(entry);
+  return delta;
+}
+
+bool ORSet::contains(const string &t_element) const { return m_entries.count(t_element); }
+
+vector<string> ORSet::elements() const {
+  vector<string> elements;
+  for (const auto &[element, dots] : m_entries)
+    elements.push_back(element);
+  return elements;
+}
+
+bool ORSet::merge(const ORSet &t_other) {
+  bool changed = false;
+  for (const auto &uid : t_other.m_forgotten)
+    if (!m_forgotten.count(uid)) {
+      forget(uid);
+      changed = true;
+    }
+
+  // A dot the other side has seen but no longer holds was removed there.
+  for (auto entry = m_entries.begin(); entry != m_entries.end();) {
+    auto theirs = t_other.m_entries.find(entry->first);
+    for (auto dot = entry->second.begin(); dot != entry->second.end();) {
+      bool held = theirs != t_other.m_entries.end() && theirs->second.count(*dot);
+      if (!held && t_other.m_seen(*dot)) {
+        dot = entry->second.erase(dot);
+        changed = true;
+      } else {
+        ++dot;
+      }
+    }
+    entry = entry->second.empty() ? m_entries.erase(entry) : std::next(entry);
+  }
+
+  // A dot this side has seen but does not hold was removed here, so only unseen ones are taken.
+  for (const auto &[element, dots] : t_other.m_entries)
+    for (const auto &dot : dots)
+      if (!m_seen(dot)) {
+        m_entries[element].insert(dot);
+        changed = true;
+      }
+
+  for (const auto &[uid, counter] : t_other.m_compact) {
+    if (m_forgotten.count(uid))
+      continue;
+    auto &ours = m_compact[uid];
+    if (counter <= ours)
+      continue;
+    ours = counter;
+    m_fold(uid);
+    changed = true;
+  }
+  for (const auto &dot : t_other.m_cloud)
+    if (!m_seen(dot)) {
+      m_insert(dot);
+      changed = true;
+    }
+
+  return changed;
+}
+
+uint64_t ORSet::hash() const {
+  size_t seed = 0;
+  for (const auto &[element, dots] : m_entries) {
+    hash_combine(seed, element);
+    for (const auto &dot : dots)
+      hash_combine(seed, dot);
+  }
+  for (const auto &[uid, counter] : m_compact)
+    if (counter)
+      hash_combine(seed, std::make_pair(uid, counter));
+  for (const auto &dot : m_cloud)
+    hash_combine(seed, dot);
+  for (const auto &uid : m_forgotten)
+    hash_combine(seed, uid);
+  return seed;
+}
+
+void ORSet::forget(const uuid &t_uid) {
+  m_forgotten.insert(t_uid);
+  m_compact.erase(t_uid);
+  m_cloud.erase(m_cloud.lower_bound({t_uid, 0}), m_cloud.upper_bound({t_uid, UINT64_MAX}));
+}
+
+namespace {
+/** Joins every value of a batch into `t_values`, and those that changed into `t_deltas`. */
+template <class T>
+size_t join(unordered_map<string, T> &t_values,
+            unordered_map<string, T> &t_deltas,
+            const vector<pair<string, T>> &t_batch) {
+  size_t changed = 0;
+  for (const auto &[key, value] : t_batch)
+    if (t_values[key].merge(value)) {
+      t_deltas[key].merge(value);
+      ++changed;
+    }
+  return changed;
+}
+
+/** Hashes every value of `t_values` by key. */
+template <class T>
+map<string, uint64_t> hashes(const unordered_map<string, T> &t_values) {
+  map<string, uint64_t> hashes;
+  for (const auto &[key, value] : t_values)
+    hashes.emplace(key, value.hash());
+  return hashes;
+}
+
+/** Adds the values whose hash `t_theirs` lacks or disagrees with to `t_batch`. */
+template <class T>
+void differ(const unordered_map<string, T> &t_values,
+            const map<string, uint64_t> &t_theirs,
+            vector<pair<string, T>> &t_batch) {
+  for (const auto &[key, value] : t_values) {
+    auto theirs = t_theirs.find(key);
+    if (theirs == t_theirs.end() || theirs->second != value.hash())
+      t_batch.emplace_back(key, value);
+  }
+}
+
+/** Folds every key of one kind into a root, summed so the order of an unordered map does not matter. */
+template <class T>
+uint64_t fold(const unordered_map<string, T> &t_values, const size_t t_kind) {
+  uint64_t root = 0;
+  for (const auto &[key, value] : t_values) {
+    size_t seed = t_kind;
+    hash_combine(seed, key);
+    hash_combine(seed, value.hash());
+    root += seed;
+  }
+  return root;
+}
+} // namespace
+
+bool Crdts::Batch::empty() const { return counters.empty() && registers.empty() && sets.empty(); }
+
+Crdts::Crdts(const uuid t_uid) : m_uid(t_uid) {}
+
+int64_t Crdts::increment(const string &t_key, const int64_t t_delta) {
+  auto &counter = m_counters[t_key];
+  m_counter_deltas[t_key].merge(counter.add(m_uid, t_delta));
+  return counter.value();
+}
+
+int64_t Crdts::counter(const string &t_key) const {
+  auto counter = m_counters.find(t_key);
+  return counter != m_counters.end() ? counter->second.value() : 0;
+}
+
+void Crdts::assign(const string &t_key, const string &t_value) {
+  auto now = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+  m_register_deltas[t_key].merge(m_registers[t_key].assign(m_uid, t_value, now));
+}
+
+optional<string> Crdts::value(const string &t_key) const {
+  auto value = m_registers.find(t_key);
+  return value != m_registers.end() ? value->second.value() : std::nullopt;
+}
+
+void Crdts::add(const string &t_key, const string &t_element) {
+  m_set_deltas[t_key].merge(m_sets[t_key].add(m_uid, t_element));
+}
+
+void Crdts::remove(const string &t_key, const string &t_element) {
+  auto set = m_sets.find(t_key);
+  if (set != m_sets.end())
+    m_set_deltas[t_key].merge(set->second.remove(t_element));
+}
+
+bool Crdts::contains(const string &t_key, const string &t_element) const {
+  auto set = m_sets.find(t_key);
+  return set != m_sets.end() && set->second.contains(t_element);
+}
+
+vector<string> Crdts::elements(const string &t_key) const {
+  auto set = m_sets.find(t_key);
+  return set != m_sets.end() ? set->second.elements() : vector<string>{};
+}
+
+size_t Crdts::merge(const Batch &t_batch) {
+  return join(m_counters, m_counter_deltas, t_batch.counters) +
+         join(m_registers, m_register_deltas, t_batch.registers) +
+         join(m_sets, m_set_deltas, t_batch.sets);
+}
+
+bool Crdts::pending() const { return !m_counter_deltas.empty() || !m_register_deltas.empty() || !m_set_deltas.empty(); }
+
+Crdts::Batch Crdts::take() {
+  Batch batch{{m_counter_deltas.begin(), m_counter_deltas.end()},
+              {m_register_deltas.begin(), m_register_deltas.end()},
+              {m_set_deltas.begin(), m_set_deltas.end()}};
+  m_counter_deltas.clear();
+  m_register_deltas.clear();
+  m_set_deltas.clear();
+  return batch;
+}
+
+Crdts::Batch Crdts::snapshot() const {
+  return {{m_counters.begin(), m_counters.end()},
+          {m_registers.begin(), m_registers.end()},
+          {m_sets.begin(), m_sets.end()}};
+}
+
+size_t Crdts::size() const { return m_counters.size() + m_registers.size() + m_sets.size(); }
+
+Crdts::Digest Crdts::digest() const { return {hashes(m_counters), hashes(m_registers), hashes(m_sets)}; }
+
+uint64_t Crdts::root() const { return fold(m_counters, 1) + fold(m_registers, 2) + fold(m_sets, 3); }
+
+Crdts::Batch Crdts::diff(const Digest &t_theirs) const {
+  Batch batch;
+  differ(m_counters, t_theirs.counters, batch.counters);
+  differ(m_registers, t_theirs.registers, batch.registers);
+  differ(m_sets, t_theirs.sets, batch.sets);
+  return batch;
+}
+
+void Crdts::forget(const uuid &t_uid) {
+  for (auto &[key, set] : m_sets)
+    set.forget(t_uid);
+}
+
+}; // namespace gossip
@@ -0,0 +1,228 @@
+#ifndef CRDT_HPP
+#define CRDT_HPP
+
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/set.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/unordered_map.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_hash.hpp>
+#include <boost/uuid/uuid_serialize.hpp>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using boost::uuids::uuid;
+using std::map;
+using std::optional;
+using std::pair;
+using std::set;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace gossip {
+
+/**
+ * A counter every member may change without coordination. Each member owns one
+ * slot holding everything it ever added and everything it ever subtracted;
+ * slots only grow, so replicas merge by taking the larger of each.
+ */
+class PNCounter {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &m_slots;
+  };
+
+  unordered_map<uuid, pair<uint64_t, uint64_t>> m_slots;
+
+public:
+  /** Applies `t_delta` as member `t_uid`; returns the delta state, that member's slot alone. */
+  PNCounter add(const uuid &t_uid, const int64_t t_delta);
+  int64_t value() const;
+
+  /** Joins another replica or delta in; returns whether this one changed. */
+  bool merge(const PNCounter &t_other);
+
+  /** A hash of the state, equal on two replicas exactly when they have converged. */
+  uint64_t hash() const;
+};
+
+/** A single value where the latest write wins; ties between members break on the uid. */
+class LWWRegister {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &m_value;
+    ar &m_time;
+    ar &m_uid;
+  };
+
+  string m_value;
+  uint64_t m_time = 0;
+  uuid m_uid{};
+
+public:
+  /** Writes as member `t_uid` at `t_time`, nudged past the current write so a local write always wins. */
+  LWWRegister assign(const uuid &t_uid, const string &t_value, const uint64_t t_time);
+  optional<string> value() const;
+  bool merge(const LWWRegister &t_other);
+  uint64_t hash() const;
+};
+
+/**
+ * An add-wins observed-remove set. Every add is tagged with a dot, the adding
+ * member and its count of adds so far; a remove drops the dots it has seen, so
+ * an add concurrent with a remove survives. The causal context records every
+ * dot seen, compacted to a per-member maximum plus the dots past a gap, which
+ * lets deltas arrive out of order or not at all. The context of a member that
+ * left is eventually forgotten; the forgotten members travel with the state, so
+ * a replica that has not forgotten one yet cannot write its context back.
+ */
+class ORSet {
+  typedef pair<uuid, uint64_t> Dot;
+
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &m_entries;
+    ar &m_compact;
+    ar &m_cloud;
+    if (version >= 1)
+      ar &m_forgotten;
+  };
+
+  map<string, set<Dot>> m_entries;
+  map<uuid, uint64_t> m_compact;
+  set<Dot> m_cloud;
+  set<uuid> m_forgotten;
+
+  bool m_seen(const Dot &t_dot) const;
+  void m_insert(const Dot &t_dot);
+  void m_fold(const uuid &t_uid);
+
+public:
+  /** Adds as member `t_uid`, replacing the element's earlier dots; returns the delta state. */
+  ORSet add(const uuid &t_uid, const string &t_element);
+
+  /** Removes every dot of the element seen so far; returns the delta state. */
+  ORSet remove(const string &t_element);
+
+  bool contains(const string &t_element) const;
+  vector<string> elements() const;
+  bool merge(const ORSet &t_other);
+  uint64_t hash() const;
+
+  /**
+   * Drops the context of member `t_uid`; every dot of it counts as seen from
+   * then on, and merges pass the forget on. Only safe once every replica has
+   * applied every remove of that member's dots.
+   */
+  void forget(const uuid &t_uid);
+};
+
+/**
+ * The CRDT values of one member, replicated to every member rather than owned by
+ * a partition, so writes apply locally in O(1) and never leave the node. Each
+ * write also joins its delta into a pending batch that the member gossips on its
+ * next tick; merged deltas that changed anything are passed on in turn, and a
+ * periodic exchange of digests finds and repairs the keys whose deltas were lost.
+ */
+class Crdts {
+public:
+  /** Values by key as shipped between members, either deltas or a full snapshot. */
+  struct Batch {
+    friend class boost::serialization::access;
+    template <class Archive>
+    void serialize(Archive &ar, const unsigned int version) {
+      ar &counters;
+      ar &registers;
+      ar &sets;
+    };
+
+    vector<pair<string, PNCounter>> counters;
+    vector<pair<string, LWWRegister>> registers;
+    vector<pair<string, ORSet>> sets;
+
+    bool empty() const;
+  };
+
+  /** A hash per key, so two members find the keys they disagree on without shipping the values. */
+  struct Digest {
+    friend class boost::serialization::access;
+    template <class Archive>
+    void serialize(Archive &ar, const unsigned int version) {
+      ar &counters;
+      ar &registers;
+      ar &sets;
+    };
+
+    map<string, uint64_t> counters;
+    map<string, uint64_t> registers;
+    map<string, uint64_t> sets;
+  };
+
+private:
+  uuid m_uid;
+  unordered_map<string, PNCounter> m_counters;
+  unordered_map<string, LWWRegister> m_registers;
+  unordered_map<string, ORSet> m_sets;
+  unordered_map<string, PNCounter> m_counter_deltas;
+  unordered_map<string, LWWRegister> m_register_deltas;
+  unordered_map<string, ORSet> m_set_deltas;
+
+public:
+  Crdts(const uuid t_uid = {});
+
+  /** Adds `t_delta` to a counter and returns its value on this member. */
+  int64_t increment(const string &t_key, const int64_t t_delta = 1);
+  int64_t counter(const string &t_key) const;
+
+  void assign(const string &t_key, const string &t_value);
+  optional<string> value(const string &t_key) const;
+
+  void add(const string &t_key, const string &t_element);
+  void remove(const string &t_key, const string &t_element);
+  bool contains(const string &t_key, const string &t_element) const;
+  vector<string> elements(const string &t_key) const;
+
+  /** Joins a batch from another member; the keys that changed are queued to be passed on. Returns how many did. */
+  size_t merge(const Batch &t_batch);
+
+  /** Whether there are deltas waiting to be gossiped. */
+  bool pending() const;
+
+  /** Hands over the waiting deltas and clears them. */
+  Batch take();
+
+  /** The full state of every key. */
+  Batch snapshot() const;
+  size_t size() const;
+
+  Digest digest() const;
+
+  /** One hash over every key; two members with equal roots have nothing to repair. */
+  uint64_t root() const;
+
+  /** The full state of every key whose hash differs from, or is missing in, `t_theirs`. */
+  Batch diff(const Digest &t_theirs) const;
+
+  /** Drops the causal context kept for a member that left from every set; other members learn of it through merges. */
+  void forget(const uuid &t_uid);
+};
+
+}; // namespace gossip
+
+BOOST_CLASS_VERSION(gossip::ORSet, 1);
+
+#endif
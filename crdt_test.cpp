@@ -0,0 +1,153 @@
+#include <boost/uuid/uuid_generators.hpp>
+#include <iostream>
+#include <string>
+
+#include "crdt.hpp"
+
+using boost::uuids::random_generator;
+using gossip::Crdts;
+using gossip::LWWRegister;
+using gossip::ORSet;
+using gossip::PNCounter;
+using std::string;
+
+namespace {
+
+int failures = 0;
+
+void check(const bool t_ok, const string &t_what) {
+  if (t_ok)
+    return;
+  ++failures;
+  std::cerr << "FAILED: " << t_what << std::endl;
+}
+
+/** Merges each of `t_a` and `t_b` into a copy of the other and checks both orders converge, then that a repeat changes nothing. */
+template <class T>
+void laws(const string &t_name, const T &t_a, const T &t_b) {
+  T ab = t_a, ba = t_b;
+  ab.merge(t_b);
+  ba.merge(t_a);
+  check(ab.hash() == ba.hash(), t_name + ": merge is commutative");
+
+  T again = ab;
+  check(!again.merge(t_b) && !again.merge(t_a) && again.hash() == ab.hash(), t_name + ": merge is idempotent");
+  check(!again.merge(again), t_name + ": merging itself is a no-op");
+}
+
+void counters() {
+  random_generator uids;
+  auto a_uid = uids(), b_uid = uids();
+  PNCounter a, b;
+  a.add(a_uid, 5);
+  a.add(a_uid, -2);
+  b.add(b_uid, 7);
+  laws("PNCounter", a, b);
+
+  a.merge(b);
+  check(a.value() == 10, "PNCounter: sums every member's slot");
+  auto delta = b.add(b_uid, -4);
+  check(a.merge(delta) && a.value() == 6, "PNCounter: applies a delta");
+}
+
+void registers() {
+  random_generator uids;
+  auto a_uid = uids(), b_uid = uids();
+  LWWRegister a, b;
+  a.assign(a_uid, "a", 10);
+  b.assign(b_uid, "b", 10);
+  laws("LWWRegister", a, b);
+
+  // Equal times break on the uid, so both sides settle on the same value.
+  LWWRegister ab = a, ba = b;
+  ab.merge(b);
+  ba.merge(a);
+  check(ab.value() == ba.value(), "LWWRegister: a tie settles on one value");
+
+  b.assign(b_uid, "later", 20);
+  a.merge(b);
+  check(a.value() == string("later"), "LWWRegister: the later write wins");
+}
+
+void sets() {
+  random_generator uids;
+  auto a_uid = uids(), b_uid = uids();
+  ORSet a, b;
+  a.add(a_uid, "x");
+  a.add(a_uid, "y");
+  b.add(b_uid, "y");
+  b.add(b_uid, "z");
+  laws("ORSet", a, b);
+
+  // Both see "x", then one removes it while the other adds it again.
+  b.merge(a);
+  ORSet removed = b, readded = b;
+  auto remove = removed.remove("x");
+  auto add = readded.add(b_uid, "x");
+  laws("ORSet concurrent", removed, readded);
+  removed.merge(add);
+  readded.merge(remove);
+  check(removed.contains("x") && readded.contains("x"), "ORSet: an add concurrent with a remove wins");
+  check(removed.hash() == readded.hash(), "ORSet: replicas converge after a concurrent add and remove");
+
+  // A remove that saw the add wins over it.
+  auto later = readded.remove("x");
+  removed.merge(later);
+  check(!removed.contains("x"), "ORSet: a remove after the add wins");
+}
+
+void forgotten() {
+  random_generator uids;
+  auto gone = uids(), live = uids();
+  ORSet a, b;
+  a.add(gone, "x");
+  a.add(gone, "y");
+  a.remove("y");
+  b.merge(a);
+
+  // Only `a` has passed the forget point; `b` still holds the departed member's context.
+  a.forget(gone);
+  ORSet before = a;
+  a.merge(b);
+  check(a.hash() == before.hash(), "ORSet: a forgotten member's context is not written back");
+  check(a.contains("x") && !a.contains("y"), "ORSet: forgetting keeps the live elements");
+
+  b.merge(a);
+  check(b.hash() == a.hash(), "ORSet: a merge passes the forget on");
+
+  auto remove = b.remove("x");
+  a.add(live, "z");
+  a.merge(remove);
+  check(!a.contains("x") && a.contains("z"), "ORSet: a forgotten member's element can still be removed");
+}
+
+void digests() {
+  random_generator uids;
+  Crdts a(uids()), b(uids());
+  a.increment("shared");
+  b.merge(a.snapshot());
+  a.increment("counter", 3);
+  a.assign("register", "v");
+  b.add("set", "e");
+
+  auto diff = a.diff(b.digest());
+  check(diff.counters.size() == 1 && diff.counters[0].first == "counter", "Crdts::diff: only the counters that differ");
+  check(diff.registers.size() == 1 && diff.sets.empty(), "Crdts::diff: keys the other side lacks are sent, its own are not");
+
+  b.merge(diff);
+  a.merge(b.diff(a.digest()));
+  check(a.root() == b.root(), "Crdts::diff: exchanging diffs both ways converges");
+  check(a.diff(b.digest()).empty() && b.diff(a.digest()).empty(), "Crdts::diff: nothing to repair once converged");
+}
+} // namespace
+
+int main() {
+  counters();
+  registers();
+  sets();
+  forgotten();
+  digests();
+  if (failures)
+    std::cerr << failures << " checks failed" << std::endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include "detector.hpp"
+
+namespace gossip {
+
+bool Detector::probing(const udp::endpoint &t_peer) const { return m_probes.contains(t_peer); }
+
+void Detector::sent(const udp::endpoint &t_peer, const uint32_t t_sequence, const steady_clock::time_point t_now) {
+  m_probes[t_peer] = Probe{t_sequence, t_now, t_now + timeout(t_peer)};
+}
+
+bool Detector::acked(const udp::endpoint &t_peer, const uint32_t t_sequence, const steady_clock::time_point t_now) {
+  auto probe = m_probes.find(t_peer);
+  if (probe == m_probes.end() || probe->second.sequence != t_sequence)
+    return false;
+
+  auto sample = t_now - probe->second.sent;
+  m_probes.erase(probe);
+
+  // RFC 6298 with alpha = 1/8 and beta = 1/4.
+  Estimate &estimate = m_estimates[t_peer];
+  if (!estimate.measured) {
+    estimate.srtt = sample;
+    estimate.rttvar = sample / 2;
+    estimate.measured = true;
+  } else {
+    auto delta = estimate.srtt > sample ? estimate.srtt - sample : sample - estimate.srtt;
+    estimate.rttvar = (3 * estimate.rttvar + delta) / 4;
+    estimate.srtt = (7 * estimate.srtt + sample) / 8;
+  }
+  estimate.failures = 0;
+
+  m_health = std::max(m_health - 1, 0);
+  return true;
+}
+
+vector<udp::endpoint> Detector::expired(const steady_clock::time_point t_now) {
+  vector<udp::endpoint> peers;
+  for (auto it = m_probes.begin(); it != m_probes.end();) {
+    if (it->second.deadline > t_now) {
+      ++it;
+      continue;
+    }
+
+    ++m_estimates[it->first].failures;
+    m_health = std::min(m_health + 1, m_max_health);
+    peers.push_back(it->first);
+    it = m_probes.erase(it);
+  }
+
+  return peers;
+}
+
+void Detector::lag(const steady_clock::duration t_lag, const steady_clock::duration t_interval) {
+  if (t_lag > t_interval)
+    m_health = std::min(m_health + 1, m_max_health);
+}
+
+steady_clock::duration Detector::timeout(const udp::endpoint &t_peer) const {
+  steady_clock::duration rto = milliseconds(m_initial_timeout);
+  auto estimate = m_estimates.find(t_peer);
+  if (estimate != m_estimates.end() && estimate->second.measured)
+    rto = estimate->second.srtt + 4 * estimate->second.rttvar;
+
+  rto = std::clamp<steady_clock::duration>(rto, milliseconds(m_min_timeout), milliseconds(m_max_timeout));
+  return rto * (m_health + 1);
+}
+
+steady_clock::duration Detector::rtt(const udp::endpoint &t_peer) const {
+  auto estimate = m_estimates.find(t_peer);
+  return estimate == m_estimates.end() ? steady_clock::duration{} : estimate->second.srtt;
+}
+
+uint32_t Detector::failures(const udp::endpoint &t_peer) const {
+  auto estimate = m_estimates.find(t_peer);
+  return estimate == m_estimates.end() ? 0 : estimate->second.failures;
+}
+
+void Detector::forget(const udp::endpoint &t_peer) {
+  m_estimates.erase(t_peer);
+  m_probes.erase(t_peer);
+}
+
+int32_t Detector::health() const { return m_health; }
+
+int32_t &Detector::initial_timeout() { return m_initial_timeout; }
+const int32_t &Detector::initial_timeout() const { return m_initial_timeout; }
+
+int32_t &Detector::min_timeout() { return m_min_timeout; }
+const int32_t &Detector::min_timeout() const { return m_min_timeout; }
+
+int32_t &Detector::max_timeout() { return m_max_timeout; }
+const int32_t &Detector::max_timeout() const { return m_max_timeout; }
+
+int32_t &Detector::max_health() { return m_max_health; }
+const int32_t &Detector::max_health() const { return m_max_health; }
+
+}; // namespace gossip
@@ -0,0 +1,96 @@
+#ifndef DETECTOR_HPP
+#define DETECTOR_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using boost::asio::ip::udp;
+using std::map;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace gossip {
+
+/**
+ * Failure detector timing. Keeps a smoothed round-trip time and variance per
+ * peer from probe acknowledgements (RFC 6298) and a local health score in the
+ * spirit of Lifeguard: it rises when our own event loop falls behind or a probe
+ * goes unanswered and falls with every answered probe, stretching all timeouts
+ * while this node is the likely culprit.
+ */
+class Detector {
+  struct Estimate {
+    steady_clock::duration srtt{};
+    steady_clock::duration rttvar{};
+    bool measured = false;
+    uint32_t failures = 0;
+  };
+
+  struct Probe {
+    uint32_t sequence;
+    steady_clock::time_point sent;
+    steady_clock::time_point deadline;
+  };
+
+  map<udp::endpoint, Estimate> m_estimates;
+  map<udp::endpoint, Probe> m_probes;
+  int32_t m_health = 0;
+
+  int32_t m_initial_timeout = 1000;
+  int32_t m_min_timeout = 50;
+  int32_t m_max_timeout = 10000;
+  int32_t m_max_health = 8;
+
+public:
+  /** Whether a probe to a peer is still awaiting its acknowledgement. */
+  bool probing(const udp::endpoint &t_peer) const;
+
+  /** Starts timing a probe to a peer, replacing any probe still outstanding to it. */
+  void sent(const udp::endpoint &t_peer, const uint32_t t_sequence, const steady_clock::time_point t_now);
+
+  /** Completes a probe and folds its round trip into the peer's estimate; false if it was unknown or late. */
+  bool acked(const udp::endpoint &t_peer, const uint32_t t_sequence, const steady_clock::time_point t_now);
+
+  /** Drops the probes that timed out and returns their peers, each charged one consecutive failure. */
+  vector<udp::endpoint> expired(const steady_clock::time_point t_now);
+
+  /** Reports how late the event loop ran a tick relative to `t_interval`. */
+  void lag(const steady_clock::duration t_lag, const steady_clock::duration t_interval);
+
+  /** The retransmission timeout for a peer, stretched by the local health multiplier. */
+  steady_clock::duration timeout(const udp::endpoint &t_peer) const;
+
+  /** The smoothed round-trip time to a peer, or zero before the first sample. */
+  steady_clock::duration rtt(const udp::endpoint &t_peer) const;
+
+  /** The number of probes to a peer that went unanswered in a row. */
+  uint32_t failures(const udp::endpoint &t_peer) const;
+  void forget(const udp::endpoint &t_peer);
+
+  /** The local health score; timeouts are multiplied by `health() + 1`. */
+  int32_t health() const;
+
+  /** The timeout in milliseconds used for a peer before its first round-trip sample. */
+  int32_t &initial_timeout();
+  const int32_t &initial_timeout() const;
+
+  /** The lower bound in milliseconds of a peer's timeout before the health multiplier. */
+  int32_t &min_timeout();
+  const int32_t &min_timeout() const;
+
+  /** The upper bound in milliseconds of a peer's timeout before the health multiplier. */
+  int32_t &max_timeout();
+  const int32_t &max_timeout() const;
+
+  /** The saturation point of the local health score. */
+  int32_t &max_health();
+  const int32_t &max_health() const;
+};
+
+}; // namespace gossip
+
+#endif
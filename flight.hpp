@@ -0,0 +1,52 @@
+#ifndef FLIGHT_HPP
+#define FLIGHT_HPP
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "completion.hpp"
+
+using std::map;
+using std::vector;
+
+namespace gossip {
+
+/**
+ * Coalesces concurrent operations on the same key: the first caller starts the
+ * operation, later callers only attach, and every caller completes from the one
+ * result passed to `resolve`.
+ */
+template <typename Key, typename... Result>
+class SingleFlight {
+public:
+  typedef Completion<const Result...> CallbackFn;
+
+  /** Attaches a callback; returns true when the caller is the one that must start the operation. */
+  bool join(const Key &t_key, CallbackFn t_callback) {
+    auto [it, inserted] = m_flights.try_emplace(t_key);
+    it->second.push_back(std::move(t_callback));
+    return inserted;
+  }
+
+  void resolve(const Key &t_key, const Result... t_result) {
+    auto it = m_flights.find(t_key);
+    if (it == m_flights.end())
+      return;
+
+    auto callbacks = std::move(it->second);
+    m_flights.erase(it);
+    for (auto &callback : callbacks)
+      callback(t_result...);
+  }
+
+  bool contains(const Key &t_key) const { return m_flights.contains(t_key); }
+  size_t size() const { return m_flights.size(); }
+
+private:
+  map<Key, vector<CallbackFn>> m_flights;
+};
+
+}; // namespace gossip
+
+#endif
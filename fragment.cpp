@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <string>
+
+#include "fragment.hpp"
+
+using std::min;
+using std::string;
+
+namespace gossip {
+namespace {
+/** The bookkeeping a transfer of `t_count` parts costs before any of them arrives. */
+size_t overhead(const size_t t_count) { return t_count * (sizeof(string) + 1); }
+} // namespace
+
+pair<uint32_t, vector<string>> Fragments::split(const string &t_data,
+                                                const size_t t_size,
+                                                const steady_clock::time_point t_expiry) {
+  vector<string> parts;
+  for (size_t offset = 0; offset < t_data.size(); offset += t_size)
+    parts.push_back(t_data.substr(offset, min(t_size, t_data.size() - offset)));
+
+  uint32_t transfer = ++m_transfer;
+  m_outbound[transfer] = Outbound{parts, t_expiry};
+  return {transfer, parts};
+}
+
+void Fragments::m_evict(const size_t t_incoming) {
+  while (!m_inbound.empty() && m_bytes + t_incoming > m_limit) {
+    auto oldest = std::min_element(m_inbound.begin(), m_inbound.end(), [](const auto &lhs, const auto &rhs) {
+      return lhs.second.deadline < rhs.second.deadline;
+    });
+    m_bytes -= oldest->second.bytes;
+    m_inbound.erase(oldest);
+  }
+}
+
+optional<string> Fragments::insert(const udp::endpoint &t_peer,
+                                   const uint32_t t_transfer,
+                                   const uint32_t t_index,
+                                   const uint32_t t_count,
+                                   const string &t_bytes,
+                                   const steady_clock::time_point t_deadline,
+                                   const steady_clock::time_point t_nack_at) {
+  // The count comes off the wire, so the vectors it sizes are charged against the limit too.
+  if (t_count == 0 || t_index >= t_count || overhead(t_count) + t_bytes.size() > m_limit)
+    return {};
+
+  auto key = std::make_pair(t_peer, t_transfer);
+  auto it = m_inbound.find(key);
+  if (it == m_inbound.end()) {
+    m_evict(overhead(t_count) + t_bytes.size());
+    Inbound inbound;
+    inbound.parts.resize(t_count);
+    inbound.received.resize(t_count, false);
+    inbound.remaining = t_count;
+    inbound.bytes = overhead(t_count);
+    inbound.deadline = t_deadline;
+    m_bytes += inbound.bytes;
+    it = m_inbound.emplace(key, std::move(inbound)).first;
+  } else if (it->second.parts.size() != t_count) {
+    return {};
+  }
+
+  Inbound &inbound = it->second;
+  inbound.nack_at = t_nack_at;
+  if (inbound.received[t_index])
+    return {};
+
+  m_evict(t_bytes.size());
+  if (!m_inbound.contains(key))
+    return {};
+
+  inbound.parts[t_index] = t_bytes;
+  inbound.received[t_index] = true;
+  inbound.bytes += t_bytes.size();
+  m_bytes += t_bytes.size();
+  if (--inbound.remaining > 0)
+    return {};
+
+  string data;
+  data.reserve(inbound.bytes - overhead(inbound.parts.size()));
+  for (const auto &part : inbound.parts)
+    data += part;
+
+  m_bytes -= inbound.bytes;
+  m_inbound.erase(it);
+  return data;
+}
+
+vector<pair<uint32_t, string>> Fragments::resend(const uint32_t t_transfer, const vector<bool> &t_missing) const {
+  vector<pair<uint32_t, string>> parts;
+  auto it = m_outbound.find(t_transfer);
+  if (it == m_outbound.end())
+    return parts;
+
+  for (uint32_t index = 0; index < t_missing.size() && index < it->second.parts.size(); ++index) {
+    if (t_missing[index])
+      parts.emplace_back(index, it->second.parts[index]);
+  }
+
+  return parts;
+}
+
+vector<Fragments::Nack> Fragments::tick(const steady_clock::time_point t_now, const steady_clock::duration t_nack_interval) {
+  std::erase_if(m_outbound, [t_now](const auto &item) { return item.second.expiry < t_now; });
+
+  vector<Nack> nacks;
+  for (auto it = m_inbound.begin(); it != m_inbound.end();) {
+    Inbound &inbound = it->second;
+    if (inbound.deadline < t_now) {
+      m_bytes -= inbound.bytes;
+      it = m_inbound.erase(it);
+      continue;
+    }
+
+    if (inbound.nack_at < t_now) {
+      vector<bool> missing(inbound.received.size());
+      for (size_t i = 0; i < missing.size(); ++i)
+        missing[i] = !inbound.received[i];
+      nacks.push_back(Nack{it->first.first, it->first.second, missing});
+      inbound.nack_at = t_now + t_nack_interval;
+    }
+    ++it;
+  }
+
+  return nacks;
+}
+
+size_t &Fragments::limit() { return m_limit; }
+const size_t &Fragments::limit() const { return m_limit; }
+
+}; // namespace gossip
@@ -0,0 +1,88 @@
+#ifndef FRAGMENT_HPP
+#define FRAGMENT_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using boost::asio::ip::udp;
+using std::map;
+using std::optional;
+using std::pair;
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+namespace gossip {
+
+/**
+ * Bookkeeping for messages too large for one datagram: the fragments we sent,
+ * kept for selective retransmission, and the partial transfers we are
+ * reassembling, bounded in total bytes and dropped when they time out.
+ */
+class Fragments {
+public:
+  struct Nack {
+    udp::endpoint peer;
+    uint32_t transfer;
+    vector<bool> missing;
+  };
+
+private:
+  struct Outbound {
+    vector<string> parts;
+    steady_clock::time_point expiry;
+  };
+
+  struct Inbound {
+    vector<string> parts;
+    vector<bool> received;
+    size_t remaining = 0;
+    size_t bytes = 0;
+    steady_clock::time_point deadline;
+    steady_clock::time_point nack_at;
+  };
+
+  uint32_t m_transfer = 0;
+  size_t m_bytes = 0;
+  map<uint32_t, Outbound> m_outbound;
+  map<pair<udp::endpoint, uint32_t>, Inbound> m_inbound;
+
+  size_t m_limit = 64 << 20;
+
+  void m_evict(const size_t t_incoming);
+
+public:
+  /** Splits a payload into parts of at most `t_size` bytes under a fresh transfer id and keeps them for resends. */
+  pair<uint32_t, vector<string>> split(const string &t_data,
+                                       const size_t t_size,
+                                       const steady_clock::time_point t_expiry);
+
+  /** Stores one part; returns the whole payload once every part of the transfer has arrived. */
+  optional<string> insert(const udp::endpoint &t_peer,
+                          const uint32_t t_transfer,
+                          const uint32_t t_index,
+                          const uint32_t t_count,
+                          const string &t_bytes,
+                          const steady_clock::time_point t_deadline,
+                          const steady_clock::time_point t_nack_at);
+
+  /** The parts of one of our transfers that a peer reported missing. */
+  vector<pair<uint32_t, string>> resend(const uint32_t t_transfer, const vector<bool> &t_missing) const;
+
+  /** Drops expired transfers and returns a NACK for every incomplete one that stalled past `t_now`. */
+  vector<Nack> tick(const steady_clock::time_point t_now, const steady_clock::duration t_nack_interval);
+
+  /** The maximum number of bytes buffered across all partial inbound transfers. */
+  size_t &limit();
+  const size_t &limit() const;
+};
+
+}; // namespace gossip
+
+#endif
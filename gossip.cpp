@@ -5,6 +5,7 @@
 #include <boost/core/demangle.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/serialization/shared_ptr.hpp>
+#include <cmath>
 #include <deque>
 #include <iostream>
 #include <map>
@@ -18,40 +19,143 @@
 
 using boost::archive::text_iarchive;
 using boost::asio::buffer;
+using boost::asio::co_spawn;
 using boost::asio::dynamic_buffer;
+using boost::asio::get_associated_executor;
 using boost::asio::io_service;
 using boost::asio::ip::address;
 using boost::asio::ip::port_type;
 using boost::asio::ip::udp;
+using boost::asio::post;
+using boost::asio::use_awaitable;
+using boost::asio::use_awaitable_t;
 using boost::core::demangle;
 using boost::system::error_code;
+using boost::asio::ip::tcp;
 using gossip::Member;
+using gossip::message::Ack;
+using gossip::message::Delta;
+using gossip::message::Digest;
+using gossip::message::Entries;
+using gossip::message::Fragment;
+using gossip::message::Get;
 using gossip::message::Hello;
+using gossip::message::Hot;
+using gossip::message::Invalidate;
 using gossip::message::IMessages;
 using gossip::message::IMessages_Ptr;
+using gossip::message::Memberlist;
 using gossip::message::Message;
+using gossip::message::MultiGet;
+using gossip::message::MultiSet;
+using gossip::message::MultiValue;
+using gossip::message::Nack;
+using gossip::message::Obituary;
+using gossip::message::Ping;
+using gossip::message::Roster;
+using gossip::message::Summary;
+using gossip::message::Value;
 using gossip::message::Welcome;
 using std::async;
 using std::future;
 using std::istringstream;
 using std::make_shared;
 using std::mt19937;
+using std::sort;
+using std::shuffle;
+using std::static_pointer_cast;
 using std::random_device;
 using std::set;
 using std::shared_future;
 using std::shared_ptr;
 using std::string;
 using std::thread;
+using std::type_index;
 using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 using std::this_thread::sleep_for;
+using std::this_thread::sleep_until;
 
 namespace gossip {
+namespace {
+/** How many `resume_with` initiations this thread is inside; asio must not resume a coroutine from its own. */
+thread_local uint32_t initiating = 0;
+
+/**
+ * Suspends the calling coroutine until `t_start` calls the move-only function
+ * it is handed, and resumes it with that call's argument. The function owns the
+ * completion handler itself, so the Completion `t_start` parks it in holds the
+ * coroutine directly. Resumption is inline, except when `t_start` completes
+ * before returning, as a local hit does; only then is it posted.
+ */
+template <class T, class Start>
+awaitable<T> resume_with(Start t_start) {
+  return boost::asio::async_initiate<const use_awaitable_t<> &, void(T)>(
+      [t_start](auto t_handler) mutable {
+        ++initiating;
+        t_start([handler = std::move(t_handler)](T t_value) mutable {
+          if (!initiating) {
+            std::move(handler)(std::move(t_value));
+            return;
+          }
+          auto executor = get_associated_executor(handler);
+          post(executor, [handler = std::move(handler), t_value = std::move(t_value)]() mutable {
+            std::move(handler)(std::move(t_value));
+          });
+        });
+        --initiating;
+      },
+      use_awaitable);
+}
+
+/** A member's placement score for a partition, from its uid hashed once per rebalance and the partition's seed. */
+uint64_t score(const uint64_t t_member, const uint64_t t_seed) {
+  uint64_t value = t_member ^ t_seed;
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
+
+/** A Prometheus label pair naming an endpoint, e.g. `peer="10.0.0.1:7777"`. */
+string label(const string &t_name, const udp::endpoint &t_endpoint) {
+  std::ostringstream out;
+  out << t_name << "=\"" << t_endpoint << "\"";
+  return out.str();
+}
+} // namespace
 
 Gossip::Gossip(const Member t_self_member,
                const ReceiverFn t_receiver)
     : m_self_member(make_shared<Member>(t_self_member)),
-      m_socket(m_context, t_self_member.address()),
-      m_receiver(t_receiver) {}
+      m_receiver(t_receiver),
+      m_cache(t_self_member.uid()),
+      m_crdts(t_self_member.uid()) {
+  m_transport = make_shared<UdpTransport>(m_context, t_self_member.address());
+  m_clock = make_shared<SteadyClock>(m_context);
+
+  m_instrument();
+  m_train_codec();
+  m_rebalance();
+  m_migration.start(tcp::endpoint(t_self_member.address().address(), t_self_member.address().port()));
+}
+
+Gossip::Gossip(const Member t_self_member,
+               const ReceiverFn t_receiver,
+               const shared_ptr<Transport> t_transport,
+               const shared_ptr<Clock> t_clock)
+    : m_self_member(make_shared<Member>(t_self_member)),
+      m_receiver(t_receiver),
+      m_cache(t_self_member.uid()),
+      m_crdts(t_self_member.uid()),
+      m_transport(t_transport),
+      m_clock(t_clock) {
+  m_instrument();
+  m_train_codec();
+  m_rebalance();
+}
 
 void Gossip::run() {
   try {
@@ -61,10 +165,11 @@ void Gossip::run() {
       }
 
       if (!m_context.poll()) {
-        m_receive_handler();
-        m_send_handler();
+        tick();
 
-        sleep_for(milliseconds(gossip_tick_interval()));
+        m_context.run_until(m_tick_at);
+        if (!m_context.stopped())
+          sleep_until(m_tick_at);
       }
     }
   } catch (const std::exception &ex) {
@@ -72,6 +177,36 @@ void Gossip::run() {
   }
 }
 
+void Gossip::tick() {
+  if (m_tick_at != steady_clock::time_point{})
+    m_detector.lag(m_clock->now() - m_tick_at, m_tick);
+
+  m_receive_handler();
+  m_send_handler();
+  m_expire_pending();
+  m_migration.tick();
+  m_greet_seeds();
+  m_anti_entropy();
+  m_announce_hot_keys();
+  m_spread_deltas();
+  m_request_fragments();
+  m_probe_members();
+  m_disseminate();
+  m_adapt_tick();
+  m_sample();
+
+  m_tick_at = m_clock->now() + m_tick;
+}
+
+void Gossip::stop() {
+  m_transition(State::DESTROYED);
+  m_context.stop();
+}
+
+const steady_clock::time_point &Gossip::next_tick() const { return m_tick_at; }
+
+void Gossip::seed(const uint32_t t_seed) { m_random.seed(t_seed); }
+
 template <IMessages IMessage>
 Error Gossip::enqueue_message(const IMessage t_message,
                               const Spreading t_spreading,
@@ -83,97 +218,1205 @@ Error Gossip::enqueue_message(const IMessage t_message,
     case Spreading::DIRECT:
       message->m_header.destination = t_member;
       m_message.insert(message);
+      m_flush();
       return Error::NONE;
     case Spreading::RANDOM: {
-      decltype(m_memberlist) reservoir;
-      sample(m_memberlist.begin(), m_memberlist.end(),
-             inserter(reservoir, reservoir.begin()),
-             this->message_rumor_factor(),
-             mt19937{random_device{}()});
-      for (auto member : reservoir) {
-        message->m_header.destination = t_member;
-        m_message.insert(message);
+      for (auto member : peers(fanout())) {
+        Message::shared_ptr copy = make_shared<IMessage>(*static_pointer_cast<IMessage>(message));
+        copy->m_header.destination = member;
+        m_message.insert(copy);
       }
+      m_flush();
       return Error::NONE;
     }
     case Spreading::BROADCAST: {
       for (auto member : m_memberlist) {
-        message->m_header.destination = t_member;
-        m_message.insert(message);
+        Message::shared_ptr copy = make_shared<IMessage>(*static_pointer_cast<IMessage>(message));
+        copy->m_header.destination = member;
+        m_message.insert(copy);
       }
+      m_flush();
       return Error::NONE;
     }
   }
+
+  return Error::INVALID_MESSAGE;
+}
+
+template <IMessages IMessage>
+awaitable<Error> Gossip::async_enqueue_message(const IMessage t_message,
+                                               const Spreading t_spreading,
+                                               const Member::shared_ptr t_member) {
+  return resume_with<Error>([this, t_message, t_spreading, t_member](auto t_resume) {
+    auto error = enqueue_message(t_message, t_spreading, t_member);
+    if (error != Error::NONE)
+      t_resume(error);
+    else
+      m_flushed.emplace_back(std::move(t_resume));
+  });
 }
 
+template awaitable<Error> Gossip::async_enqueue_message(const Value t_message,
+                                                        const Spreading t_spreading,
+                                                        const Member::shared_ptr t_member);
+template awaitable<Error> Gossip::async_enqueue_message(const MultiValue t_message,
+                                                        const Spreading t_spreading,
+                                                        const Member::shared_ptr t_member);
+
 template Error Gossip::enqueue_message(const Welcome t_message,
                                        const Spreading t_spreading,
                                        const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const Value t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const Memberlist t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const Roster t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const Obituary t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const Delta t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const Summary t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const MultiValue t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const Invalidate t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
+template Error Gossip::enqueue_message(const Ack t_message,
+                                       const Spreading t_spreading,
+                                       const Member::shared_ptr t_member);
 
 Error Gossip::add_member(const Member t_member) {
-  if (m_state != State::INITIALIZED)
+  if (m_state != State::INITIALIZED && m_state != State::JOINING)
     return Error::BAD_STATE;
 
+  // Every seed is greeted at once and the first complete answer wins; listing
+  // this member's own address only marks it as one that may start the cluster.
+  m_transition(State::JOINING);
+  m_join_at = m_clock->now() + milliseconds(join_interval());
+  if (t_member.address() == self_member()->address())
+    return Error::NONE;
+
   auto member = make_shared<Member>(Member(t_member));
-  Error res = enqueue_message(Hello(self_member()), Spreading::DIRECT, member);
-  if ((uint32_t)res < 0)
-    return res;
+  m_seeds.push_back(member);
+  Hello hello(self_member());
+  hello.m_dictionaries = m_codec.dictionaries();
+  return enqueue_message(hello, Spreading::DIRECT, member);
+}
 
-  this->m_state = State::JOINING;
+Error Gossip::join(const vector<Member> &t_members, const Crdts::Batch &t_crdts) {
+  if (m_state != State::JOINING) {
+    for (const auto &member : t_members)
+      insert_member(make_shared<Member>(member));
+    return Error::NONE;
+  }
+
+  for (const auto &member : t_members)
+    m_insert_member(make_shared<Member>(member), false);
+
+  // Start from the table the cluster had without this member, so the partitions
+  // it takes over are pulled from their owners instead of assumed empty.
+  if (!m_memberlist.empty() && replication_factor() > 0)
+    m_owners = m_place({m_memberlist.begin(), m_memberlist.end()}).owners;
+  m_rebalance();
+  m_crdts.merge(t_crdts);
+
+  m_transition(State::CONNECTED);
   return Error::NONE;
 }
 
+void Gossip::welcome(const Member::shared_ptr t_member) {
+  vector<Member> members;
+  for (const auto &member : m_memberlist)
+    if (member->uid() != t_member->uid())
+      members.push_back(*member);
+  auto complete = make_shared<Welcome>(self_member(), members, m_crdts.snapshot());
+  complete->m_dictionaries = m_codec.dictionaries();
+  Message::shared_ptr welcome = complete;
+
+  if (!m_migration.started()) {
+    enqueue_message(*static_pointer_cast<Welcome>(welcome), Spreading::DIRECT, t_member);
+    return;
+  }
+
+  // The whole state goes out as one compressed frame on the stream, however large the cluster.
+  auto type = type_index(typeid(Welcome));
+  auto capabilities = m_capabilities.find(t_member->address());
+  string message = m_codec.encode(to_string(welcome), type, capabilities != m_capabilities.end() ? capabilities->second : 0);
+  auto &sent = m_type(m_sent, "gossip_messages_sent_total", type);
+  sent.count->add();
+  Trace::record(Event::SEND, t_member->address(), t_member->uid(), 0, message.size(), sent.trace);
+  m_migration.send(t_member, message);
+}
+
+void Gossip::m_greet_seeds() {
+  auto now = m_clock->now();
+  if (m_state != State::JOINING || now < m_join_at)
+    return;
+  m_join_at = now + milliseconds(join_interval());
+
+  if (m_seeds.empty()) {
+    m_transition(State::CONNECTED);
+    return;
+  }
+  Hello hello(self_member());
+  hello.m_dictionaries = m_codec.dictionaries();
+  for (const auto &seed : m_seeds)
+    enqueue_message(hello, Spreading::DIRECT, seed);
+}
+
+Error Gossip::insert_member(const Member::shared_ptr t_member) {
+  if (m_insert_member(t_member, true))
+    m_rebalance();
+  return Error::NONE;
+}
+
+bool Gossip::m_insert_member(const Member::shared_ptr t_member, const bool t_rumor) {
+  if (t_member->uid() == self_member()->uid())
+    return false;
+
+  // Only a higher incarnation, raised by the member itself, outlives a failure report.
+  auto tombstone = m_tombstones.find(t_member->uid());
+  if (tombstone != m_tombstones.end()) {
+    if (t_member->incarnation() <= tombstone->second.member.incarnation())
+      return false;
+    m_tombstones.erase(tombstone);
+  }
+
+  auto same = [&t_member](const Member::shared_ptr &member) { return member->uid() == t_member->uid(); };
+  auto known = find_if(m_memberlist.begin(), m_memberlist.end(), same);
+  if (known != m_memberlist.end()) {
+    if (t_member->incarnation() > (*known)->incarnation()) {
+      (*known)->incarnation() = t_member->incarnation();
+      if (t_rumor)
+        m_rumors[*known] = retransmits();
+    }
+    return false;
+  }
+
+  m_memberlist.insert(t_member);
+  if (t_rumor)
+    m_rumors[t_member] = retransmits();
+  Trace::record(Event::JOIN, t_member->address(), t_member->uid(), 0, m_memberlist.size());
+  auto peer = label("peer", t_member->address());
+  m_peer_instruments[t_member->address()] = PeerInstruments{
+      &m_metrics.counter("gossip_peer_sent_bytes_total", "Bytes handed to the transport per member", peer),
+      &m_metrics.counter("gossip_peer_received_bytes_total", "Bytes received per member", peer)};
+  if (m_membership_listener)
+    m_membership_listener(t_member, true);
+  if (m_rumors.size() == 1 && t_rumor)
+    m_hasten();
+  return true;
+}
+
+Error Gossip::bury(const Member t_member) {
+  if (t_member.uid() == self_member()->uid()) {
+    if (t_member.incarnation() < self_member()->incarnation())
+      return Error::NONE;
+    self_member()->incarnation() = t_member.incarnation() + 1;
+    m_rumors[self_member()] = retransmits();
+    m_hasten();
+    return Error::NONE;
+  }
+
+  auto tombstone = m_tombstones.find(t_member.uid());
+  if (tombstone != m_tombstones.end() && tombstone->second.member.incarnation() >= t_member.incarnation())
+    return Error::NONE;
+
+  auto known = find_if(m_memberlist.begin(), m_memberlist.end(), [&t_member](const Member::shared_ptr &member) {
+    return member->uid() == t_member.uid();
+  });
+  if (known != m_memberlist.end() && (*known)->incarnation() > t_member.incarnation())
+    return Error::NONE;
+
+  m_tombstones[t_member.uid()] = Tombstone{t_member, m_clock->now() + milliseconds(tombstone_ttl())};
+  m_obituaries[make_shared<Member>(t_member)] = retransmits();
+  if (m_obituaries.size() == 1)
+    m_hasten();
+  if (known != m_memberlist.end())
+    erase_member(*known);
+  return Error::NONE;
+}
+
+optional<Member> Gossip::tombstone(const uuid &t_uid) const {
+  auto tombstone = m_tombstones.find(t_uid);
+  return tombstone != m_tombstones.end() ? optional<Member>(tombstone->second.member) : std::nullopt;
+}
+
+Error Gossip::erase_member(const Member::shared_ptr t_member) {
+  auto same = [&t_member](const Member::shared_ptr &member) { return member->uid() == t_member->uid(); };
+  auto it = find_if(m_memberlist.begin(), m_memberlist.end(), same);
+  if (it == m_memberlist.end())
+    return Error::NOT_FOUND;
+
+  auto member = *it;
+  m_rumors.erase(member);
+  m_memberlist.erase(it);
+  Trace::record(Event::LEAVE, member->address(), member->uid(), 0, m_memberlist.size());
+  if (m_peer_instruments.erase(member->address())) {
+    auto peer = label("peer", member->address());
+    m_metrics.erase("gossip_peer_sent_bytes_total", peer);
+    m_metrics.erase("gossip_peer_received_bytes_total", peer);
+  }
+  m_rebalance();
+  if (m_membership_listener)
+    m_membership_listener(member, false);
+  return Error::NONE;
+}
+
+void Gossip::m_rebalance() {
+  if (replication_factor() <= 0) {
+    m_owners.assign(Cache::partition_count, self_member());
+    m_replicas.assign(Cache::partition_count, {self_member()});
+    return;
+  }
+
+  vector<Member::shared_ptr> candidates{self_member()};
+  candidates.insert(candidates.end(), m_memberlist.begin(), m_memberlist.end());
+  auto [owners, replicas] = m_place(candidates);
+
+  auto before = std::move(m_owners);
+  m_owners = std::move(owners);
+  m_replicas = std::move(replicas);
+  m_migration.rebalance(before, m_owners);
+
+  for (uint32_t partition = 0; partition < Cache::partition_count; ++partition) {
+    if (!replicates(partition) && !m_migration.outbound(partition))
+      m_instruments.evictions->add(m_cache.drop(partition));
+  }
+}
+
+Gossip::Placement Gossip::m_place(const vector<Member::shared_ptr> &t_members) const {
+  // Members that do not own partitions are left out; if none does, this one holds
+  // everything as it does before joining, and hands it over once an owner appears.
+  vector<Member::shared_ptr> candidates;
+  copy_if(t_members.begin(), t_members.end(), back_inserter(candidates), [](const Member::shared_ptr &member) {
+    return member->owner();
+  });
+  if (candidates.empty())
+    candidates.push_back(self_member());
+
+  size_t replication = std::clamp<size_t>(replication_factor(), 1, candidates.size());
+
+  Placement placement{vector<Member::shared_ptr>(Cache::partition_count),
+                      vector<vector<Member::shared_ptr>>(Cache::partition_count)};
+  vector<uint64_t> uids(candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i)
+    uids[i] = hash(boost::uuids::to_string(candidates[i]->uid()));
+
+  vector<pair<uint64_t, Member::shared_ptr>> ranked(candidates.size());
+  for (uint32_t partition = 0; partition < Cache::partition_count; ++partition) {
+    auto seed = hash(std::to_string(partition));
+    for (size_t i = 0; i < candidates.size(); ++i)
+      ranked[i] = {score(uids[i], seed), candidates[i]};
+    sort(ranked.begin(), ranked.end(), [](const auto &lhs, const auto &rhs) { return lhs.first > rhs.first; });
+
+    // The owner stays the top-scoring member; the other replicas prefer the best
+    // member of each zone not yet holding a copy, then of each rack, then score.
+    auto placed = ranked.begin();
+    std::set<string> zones, racks;
+    for (auto it = ranked.begin(); it != ranked.end() && placed - ranked.begin() < (ptrdiff_t)replication; ++it) {
+      if (zones.insert(it->second->zone()).second)
+        std::rotate(placed++, it, it + 1);
+    }
+    for (auto it = ranked.begin(); it != placed; ++it)
+      racks.insert(it->second->zone() + "/" + it->second->rack());
+    for (auto it = placed; it != ranked.end() && placed - ranked.begin() < (ptrdiff_t)replication; ++it) {
+      if (racks.insert(it->second->zone() + "/" + it->second->rack()).second)
+        std::rotate(placed++, it, it + 1);
+    }
+
+    placement.owners[partition] = ranked.front().second;
+    for (size_t i = 0; i < replication; ++i)
+      placement.replicas[partition].push_back(ranked[i].second);
+  }
+  return placement;
+}
+
+vector<Member::shared_ptr> Gossip::peers(const size_t t_count) {
+  vector<Member::shared_ptr> local, remote;
+  for (const auto &member : m_memberlist)
+    (member->zone() == self_member()->zone() ? local : remote).push_back(member);
+
+  shuffle(local.begin(), local.end(), m_random);
+  shuffle(remote.begin(), remote.end(), m_random);
+
+  std::bernoulli_distribution cross(std::clamp(cross_zone_probability(), 0.0, 1.0));
+  vector<Member::shared_ptr> peers;
+  while (peers.size() < t_count && !(local.empty() && remote.empty())) {
+    auto &pool = remote.empty() || (!local.empty() && !cross(m_random)) ? local : remote;
+    peers.push_back(pool.back());
+    pool.pop_back();
+  }
+
+  return peers;
+}
+
+Member::shared_ptr Gossip::m_route(const uint32_t t_partition) const {
+  if (m_owners.empty())
+    return nullptr;
+
+  const auto &owner = m_owners[t_partition];
+  if (owner == self_member())
+    return m_migration.source(t_partition);
+
+  if (m_migration.outbound(t_partition))
+    return nullptr;
+
+  return owner;
+}
+
+void Gossip::m_forward(const Member::shared_ptr t_target,
+                       Message::shared_ptr t_message,
+                       ValueFn t_callback) {
+  m_forward(t_target, t_message, Pending{std::move(t_callback), nullptr, {}});
+}
+
+void Gossip::m_forward(const Member::shared_ptr t_target,
+                       Message::shared_ptr t_message,
+                       Pending t_pending) {
+  t_message->m_header.remain_attempt = message_retry_attempts();
+  t_message->m_header.destination = t_target;
+  auto &pending = m_pending[t_message->m_header.sequence] = std::move(t_pending);
+  pending.started = m_clock->now();
+  pending.deadline = pending.started + milliseconds(message_retry_interval());
+  m_message.insert(t_message);
+  m_flush();
+}
+
+void Gossip::get(const string t_key, ValueFn t_callback, const uint32_t t_hops) {
+  auto partition = Cache::partition_of(t_key);
+  auto target = m_route(partition);
+  if (!target || t_hops >= (uint32_t)max_forward_hops()) {
+    m_hot_keys.touch(t_key);
+    if (t_hops && invalidate_reads())
+      m_hot_keys.announce(t_key, m_clock->now() + milliseconds(near_cache_ttl()));
+    auto entry = m_cache.get(t_key);
+    (entry ? m_instruments.hits : m_instruments.misses)->add();
+    if (entry || !m_loader) {
+      t_callback(Error::NONE, entry);
+      return;
+    }
+
+    if (m_flights.join(t_key, std::move(t_callback)))
+      m_fill(t_key);
+    return;
+  }
+
+  if (auto entry = m_near_cache.get(t_key, m_clock->now())) {
+    m_instruments.near_hits->add();
+    t_callback(Error::NONE, entry);
+    return;
+  }
+  m_instruments.near_misses->add();
+
+  // Only reads that start here are coalesced. A forwarded one could join the
+  // flight it came from when two members route to each other, and then only the
+  // deadline would end the loop that `max_forward_hops` is there to cut.
+  Message::Header header{next_sequence(), 0, nullptr};
+  if (t_hops) {
+    m_forward(target, make_shared<Get>(header, t_key, t_hops), std::move(t_callback));
+    return;
+  }
+
+  if (!m_flights.join(t_key, std::move(t_callback)))
+    return;
+
+  m_forward(target, make_shared<Get>(header, t_key, t_hops), [this, t_key](const Error t_error, const optional<Cache::Entry> t_entry) {
+    m_flights.resolve(t_key, t_error, t_entry);
+  });
+}
+
+void Gossip::m_fill(const string t_key) {
+  m_loader(t_key, [this, t_key](const optional<string> t_value) {
+    auto entry = m_cache.get(t_key);
+    if (!entry && t_value) {
+      entry = m_cache.set(t_key, *t_value);
+      m_migration.record(Cache::partition_of(t_key), t_key);
+    }
+
+    m_flights.resolve(t_key, Error::NONE, entry);
+  });
+}
+
+void Gossip::set(const string t_key, const string t_value, ValueFn t_callback, const uint32_t t_hops) {
+  auto partition = Cache::partition_of(t_key);
+  auto target = m_route(partition);
+  if (!target || t_hops >= (uint32_t)max_forward_hops()) {
+    const Cache::Entry &entry = m_cache.set(t_key, t_value);
+    m_migration.record(partition, t_key);
+    if (m_hot_keys.announced(t_key, m_clock->now())) {
+      m_hot_keys.forget(t_key);
+      enqueue_message(Invalidate{{t_key}}, Spreading::BROADCAST);
+    }
+    if (m_invalidation_listener)
+      m_invalidation_listener(t_key);
+    t_callback(Error::NONE, entry);
+    return;
+  }
+
+  m_near_cache.erase(t_key);
+  if (m_invalidation_listener)
+    m_invalidation_listener(t_key);
+
+  Message::Header header{next_sequence(), 0, nullptr};
+  m_forward(target, make_shared<gossip::message::Set>(header, t_key, t_value, t_hops), std::move(t_callback));
+}
+
+namespace {
+/** Collects per-key results of a scatter/gather call and completes once every key is answered. */
+class Gather {
+  vector<Gossip::Result> m_results;
+  size_t m_remaining;
+  Gossip::MultiFn m_callback;
+
+public:
+  Gather(const size_t t_size, Gossip::MultiFn t_callback)
+      : m_results(t_size, Gossip::Result{Error::NONE, {}}),
+        m_remaining(t_size),
+        m_callback(std::move(t_callback)) {}
+
+  void done(const size_t t_index, const Error t_error, const optional<Cache::Entry> t_entry) {
+    m_results[t_index] = Gossip::Result{t_error, t_entry};
+    if (--m_remaining == 0)
+      m_callback(m_results);
+  }
+
+  void done(const vector<size_t> &t_indices, const optional<vector<Gossip::Result>> &t_results) {
+    for (size_t i = 0; i < t_indices.size(); ++i) {
+      if (t_results && i < t_results->size())
+        done(t_indices[i], (*t_results)[i].first, (*t_results)[i].second);
+      else
+        done(t_indices[i], Error::READ_FAILED, {});
+    }
+  }
+};
+
+const size_t keys_per_batch = 64;
+} // namespace
+
+void Gossip::mget(const vector<string> t_keys, MultiFn t_callback, const uint32_t t_hops) {
+  if (t_keys.empty()) {
+    t_callback({});
+    return;
+  }
+
+  auto gather = make_shared<Gather>(t_keys.size(), std::move(t_callback));
+  map<Member::shared_ptr, vector<size_t>> batches;
+  for (size_t i = 0; i < t_keys.size(); ++i) {
+    auto target = m_route(Cache::partition_of(t_keys[i]));
+    if (!target || t_hops >= (uint32_t)max_forward_hops()) {
+      get(t_keys[i], [gather, i](const Error t_error, const optional<Cache::Entry> t_entry) { gather->done(i, t_error, t_entry); }, t_hops);
+    } else if (auto entry = m_near_cache.get(t_keys[i], m_clock->now())) {
+      m_instruments.near_hits->add();
+      gather->done(i, Error::NONE, entry);
+    } else {
+      m_instruments.near_misses->add();
+      batches[target].push_back(i);
+    }
+  }
+
+  for (const auto &[target, indices] : batches) {
+    for (size_t offset = 0; offset < indices.size(); offset += keys_per_batch) {
+      vector<size_t> batch(indices.begin() + offset, indices.begin() + std::min(offset + keys_per_batch, indices.size()));
+      vector<string> keys;
+      for (auto i : batch)
+        keys.push_back(t_keys[i]);
+
+      Message::Header header{next_sequence(), 0, nullptr};
+      m_forward(target, make_shared<MultiGet>(header, keys, t_hops),
+                Pending{nullptr, [gather, batch](const optional<vector<Result>> t_results) { gather->done(batch, t_results); }, {}});
+    }
+  }
+}
+
+void Gossip::mset(const vector<pair<string, string>> t_items, MultiFn t_callback, const uint32_t t_hops) {
+  if (t_items.empty()) {
+    t_callback({});
+    return;
+  }
+
+  auto gather = make_shared<Gather>(t_items.size(), std::move(t_callback));
+  map<Member::shared_ptr, vector<size_t>> batches;
+  for (size_t i = 0; i < t_items.size(); ++i) {
+    const auto &[key, value] = t_items[i];
+    auto target = m_route(Cache::partition_of(key));
+    if (!target || t_hops >= (uint32_t)max_forward_hops())
+      set(key, value, [gather, i](const Error t_error, const optional<Cache::Entry> t_entry) { gather->done(i, t_error, t_entry); }, t_hops);
+    else
+      batches[target].push_back(i);
+  }
+
+  for (const auto &[target, indices] : batches) {
+    for (size_t offset = 0; offset < indices.size(); offset += keys_per_batch) {
+      vector<size_t> batch(indices.begin() + offset, indices.begin() + std::min(offset + keys_per_batch, indices.size()));
+      vector<pair<string, string>> items;
+      for (auto i : batch) {
+        items.push_back(t_items[i]);
+        m_near_cache.erase(t_items[i].first);
+        if (m_invalidation_listener)
+          m_invalidation_listener(t_items[i].first);
+      }
+
+      Message::Header header{next_sequence(), 0, nullptr};
+      m_forward(target, make_shared<MultiSet>(header, items, t_hops),
+                Pending{nullptr, [gather, batch](const optional<vector<Result>> t_results) { gather->done(batch, t_results); }, {}});
+    }
+  }
+}
+
+awaitable<Gossip::Result> Gossip::async_get(const string t_key, const uint32_t t_hops) {
+  return resume_with<Result>([this, t_key, t_hops](auto t_resume) {
+    get(t_key, [resume = std::move(t_resume)](const Error t_error, const optional<Cache::Entry> t_entry) mutable {
+      resume({t_error, t_entry});
+    }, t_hops);
+  });
+}
+
+awaitable<Gossip::Result> Gossip::async_set(const string t_key, const string t_value, const uint32_t t_hops) {
+  return resume_with<Result>([this, t_key, t_value, t_hops](auto t_resume) {
+    set(t_key, t_value, [resume = std::move(t_resume)](const Error t_error, const optional<Cache::Entry> t_entry) mutable {
+      resume({t_error, t_entry});
+    }, t_hops);
+  });
+}
+
+awaitable<vector<Gossip::Result>> Gossip::async_mget(const vector<string> t_keys, const uint32_t t_hops) {
+  return resume_with<vector<Result>>([this, t_keys, t_hops](auto t_resume) {
+    mget(t_keys, [resume = std::move(t_resume)](const vector<Result> t_results) mutable { resume(t_results); }, t_hops);
+  });
+}
+
+awaitable<vector<Gossip::Result>> Gossip::async_mset(const vector<pair<string, string>> t_items, const uint32_t t_hops) {
+  return resume_with<vector<Result>>([this, t_items, t_hops](auto t_resume) {
+    mset(t_items, [resume = std::move(t_resume)](const vector<Result> t_results) mutable { resume(t_results); }, t_hops);
+  });
+}
+
+awaitable<Error> Gossip::async_ping(const Member::shared_ptr t_member, const milliseconds t_timeout) {
+  // The Ping only leaves on the next flush, so its Ack cannot beat the wait below.
+  auto probe = next_sequence();
+  enqueue_message(Ping{probe, self_member()}, Spreading::DIRECT, t_member);
+  co_return co_await async_acknowledged(probe, t_timeout);
+}
+
+awaitable<Error> Gossip::async_acknowledged(const uint32_t t_probe, const milliseconds t_timeout) {
+  return resume_with<Error>([this, t_probe, t_timeout](auto t_resume) {
+    m_pings[t_probe] = std::move(t_resume);
+    m_clock->schedule(m_clock->now() + t_timeout, [this, t_probe]() {
+      auto ping = m_pings.extract(t_probe);
+      if (!ping.empty())
+        ping.mapped()(Error::READ_FAILED);
+    });
+  });
+}
+
+void Gossip::invalidate(const vector<string> &t_keys) {
+  for (const auto &key : t_keys) {
+    m_near_cache.erase(key);
+    if (m_invalidation_listener)
+      m_invalidation_listener(key);
+  }
+}
+
+Error Gossip::complete(const uint32_t t_request, const Error t_error, const optional<Cache::Entry> t_entry) {
+  auto it = m_pending.find(t_request);
+  if (it == m_pending.end() || !it->second.callback)
+    return Error::NOT_FOUND;
+
+  m_instruments.requests->record(m_clock->now() - it->second.started);
+  auto callback = std::move(it->second.callback);
+  m_pending.erase(it);
+  callback(t_error, t_entry);
+  return Error::NONE;
+}
+
+Error Gossip::complete(const uint32_t t_request, const vector<Result> t_results) {
+  auto it = m_pending.find(t_request);
+  if (it == m_pending.end() || !it->second.batch)
+    return Error::NOT_FOUND;
+
+  m_instruments.requests->record(m_clock->now() - it->second.started);
+  auto batch = std::move(it->second.batch);
+  m_pending.erase(it);
+  batch(t_results);
+  return Error::NONE;
+}
+
+void Gossip::m_expire_pending() {
+  auto now = m_clock->now();
+  for (auto it = m_pending.begin(); it != m_pending.end();) {
+    if (it->second.deadline > now) {
+      ++it;
+      continue;
+    }
+
+    auto pending = std::move(it->second);
+    it = m_pending.erase(it);
+    if (pending.callback)
+      pending.callback(Error::READ_FAILED, {});
+    if (pending.batch)
+      pending.batch({});
+  }
+}
+
+uint64_t Gossip::membership_digest() const {
+  uint64_t digest = hash(boost::uuids::to_string(self_member()->uid()));
+  for (const auto &member : m_memberlist)
+    digest ^= hash(boost::uuids::to_string(member->uid()));
+  return digest;
+}
+
+vector<uuid> Gossip::roster() const {
+  vector<uuid> roster{self_member()->uid()};
+  for (const auto &member : m_memberlist)
+    roster.push_back(member->uid());
+  return roster;
+}
+
+void Gossip::send_digest(const Member::shared_ptr t_member,
+                         const uint64_t t_membership,
+                         const vector<Digest::Node> &t_nodes) {
+  const size_t nodes_per_message = 256;
+  size_t offset = 0;
+  do {
+    auto last = std::min(offset + nodes_per_message, t_nodes.size());
+    vector<Digest::Node> nodes(t_nodes.begin() + offset, t_nodes.begin() + last);
+    enqueue_message(Digest{offset == 0 ? t_membership : 0, nodes}, Spreading::DIRECT, t_member);
+    offset = last;
+  } while (offset < t_nodes.size());
+}
+
+void Gossip::send_entries(const Member::shared_ptr t_member,
+                          const uint32_t t_partition,
+                          const uint32_t t_leaf,
+                          const Cache::Range &t_entries,
+                          const bool t_reply) {
+  const size_t bytes_per_message = message_max_size() / 4;
+  Cache::Range entries;
+  size_t bytes = 0;
+  for (size_t i = 0; i < t_entries.size(); ++i) {
+    const auto &[key, entry] = t_entries[i];
+    bytes += key.size() + entry.value.size() + 2 * sizeof(uint64_t);
+    entries.emplace_back(key, entry);
+
+    bool last = i + 1 == t_entries.size();
+    if (last || bytes >= bytes_per_message) {
+      enqueue_message(Entries{t_partition, t_leaf, entries, t_reply && last}, Spreading::DIRECT, t_member);
+      entries.clear();
+      bytes = 0;
+    }
+  }
+
+  if (t_entries.empty() && t_reply)
+    enqueue_message(Entries{t_partition, t_leaf, {}, true}, Spreading::DIRECT, t_member);
+}
+
+void Gossip::m_announce_hot_keys() {
+  auto now = m_clock->now();
+  if (now < m_hot_keys_at)
+    return;
+  m_hot_keys_at = now + milliseconds(hot_key_window());
+
+  for (const auto &key : m_hot_keys.rotate(hot_key_threshold(), now)) {
+    auto entry = m_cache.get(key);
+    if (!entry || !replicates(Cache::partition_of(key)))
+      continue;
+
+    m_hot_keys.announce(key, now + milliseconds(near_cache_ttl()));
+    enqueue_message(Hot{key, *entry, near_cache_ttl()}, Spreading::BROADCAST);
+  }
+}
+
+void Gossip::m_anti_entropy() {
+  auto now = m_clock->now();
+  if (now < m_anti_entropy_at || m_memberlist.empty())
+    return;
+  m_anti_entropy_at = now + milliseconds(anti_entropy_interval());
+
+  vector<Member::shared_ptr> peers(m_memberlist.begin(), m_memberlist.end());
+  shuffle(peers.begin(), peers.end(), m_random);
+  const auto &peer = peers.front();
+
+  vector<Digest::Node> roots;
+  for (uint32_t partition = 0; partition < Cache::partition_count; ++partition) {
+    const auto &replicas = m_replicas[partition];
+    // Partitions still being streamed converge through the migration instead.
+    bool shared = replicates(partition) && !m_migration.outbound(partition) && !m_migration.source(partition) &&
+                  any_of(replicas.begin(), replicas.end(), [&peer](const Member::shared_ptr &member) {
+                    return member->uid() == peer->uid();
+                  });
+    if (shared)
+      roots.emplace_back(partition, 0, m_cache.tree(partition).root());
+  }
+
+  send_digest(peer, membership_digest(), roots);
+
+  // Deltas are sent once, so the roots are compared now and then to find and repair keys whose deltas were lost.
+  if (m_crdts.size())
+    enqueue_message(Summary{m_crdts.root(), 0, {}}, Spreading::DIRECT, peer);
+}
+
+void Gossip::m_spread_deltas() {
+  // Writes since the last tick travel as one batch; receivers pass on what was news to them.
+  if (!m_crdts.pending() || m_memberlist.empty())
+    return;
+
+  enqueue_message(Delta{m_crdts.take()}, Spreading::RANDOM);
+}
+
 Error Gossip::m_receive(const string t_data, const Member t_sender) {
-  BOOST_LOG_TRIVIAL(debug) << "Gossip::m_receive_hander:"
-                           << "\t[address]:" << t_sender.address();
+  auto peer = m_peer_instruments.find(t_sender.address());
+  if (peer != m_peer_instruments.end())
+    peer->second.received->add(t_data.size());
+
+  auto data = m_codec.decode(t_data);
+  if (!data) {
+    m_instruments.invalid->add();
+    Trace::record(Event::INVALID, t_sender.address(), t_sender.uid(), 0, t_data.size());
+    return Error::INVALID_MESSAGE;
+  }
 
-  istringstream iss(t_data);
-  text_iarchive ia(iss);
   Message::shared_ptr message;
-  ia >> message;
-  BOOST_LOG_TRIVIAL(trace) << "Gossip::m_receive:"
-                           << "\t -> " << demangle(typeid(*message.get()).name());
+  try {
+    istringstream iss(*data);
+    text_iarchive ia(iss);
+    ia >> message;
+  } catch (const std::exception &e) {
+    BOOST_LOG_TRIVIAL(error) << "Gossip::m_receive:"
+                             << "\t[error]:" << e.what();
+    m_instruments.invalid->add();
+    Trace::record(Event::INVALID, t_sender.address(), t_sender.uid(), 0, t_data.size());
+    return Error::INVALID_MESSAGE;
+  }
+  auto &type = m_type(m_received, "gossip_messages_received_total", type_index(typeid(*message)));
+  type.count->add();
+  Trace::record(Event::RECEIVE, t_sender.address(), t_sender.uid(), message->m_header.sequence, t_data.size(), type.trace);
 
-  message->receive(*this, m_temp_sender);
+  // Handlers that never wait run inline and return their result. Only those that
+  // wait on another member pay for a coroutine, which holds no thread while it waits.
+  if (!message->suspends())
+    return message->receive(*this, t_sender);
+
+  co_spawn(m_context, m_handle(message, t_sender), [](std::exception_ptr t_error) {
+    if (!t_error)
+      return;
+    try {
+      std::rethrow_exception(t_error);
+    } catch (const std::exception &e) {
+      BOOST_LOG_TRIVIAL(error) << "Gossip::m_handle:"
+                               << "\t[error]:" << e.what();
+    }
+  });
 
   return Error::NONE;
 }
 
+awaitable<void> Gossip::m_handle(const Message::shared_ptr t_message, const Member t_sender) {
+  // The datagram was accepted long before, so an error can only be logged.
+  auto error = co_await t_message->handle(*this, t_sender);
+  if (error != Error::NONE)
+    BOOST_LOG_TRIVIAL(warning) << "Gossip::m_handle:"
+                               << "\t[type]:" << typeid(*t_message).name() << "\t[error]:" << (int32_t)error;
+}
+
 template <IMessages_Ptr IMessage_Ptr>
 Error Gossip::m_send(IMessage_Ptr t_message) {
-  string message = to_string(t_message);
-  BOOST_LOG_TRIVIAL(debug) << "Gossip::m_send:"
-                           << "\t[address]:" << t_message->m_header.destination->address();
-
-  m_socket.async_send_to(
-      buffer(message),
-      t_message->m_header.destination->address(),
-      [this](boost::system::error_code ec, std::size_t length) {
-        if (ec)
-          return;
-      });
+  const auto &destination = t_message->m_header.destination;
+  auto type = type_index(typeid(*t_message));
+  auto capabilities = m_capabilities.find(destination->address());
+  string message = m_codec.encode(to_string(t_message),
+                                  type,
+                                  capabilities != m_capabilities.end() ? capabilities->second : 0);
+  auto &sent = m_type(m_sent, "gossip_messages_sent_total", type);
+  sent.count->add();
+  Trace::record(Event::SEND, destination->address(), destination->uid(), t_message->m_header.sequence, message.size(), sent.trace);
+
+  if (message.size() > (size_t)stream_threshold() && m_migration.started()) {
+    m_migration.send(destination, message);
+    return Error::NONE;
+  }
 
+  if (message.size() > (size_t)message_max_size()) {
+    auto expiry = m_clock->now() + milliseconds(message_retry_interval());
+    auto [transfer, parts] = m_fragments.split(message, fragment_size(), expiry);
+    for (uint32_t index = 0; index < parts.size(); ++index) {
+      Message::shared_ptr fragment = make_shared<Fragment>(transfer, index, parts.size(), parts[index]);
+      m_send_datagram(destination->address(), to_string(fragment));
+    }
+    return Error::NONE;
+  }
+
+  m_send_datagram(destination->address(), message);
   return Error::NONE;
 }
 
-void Gossip::m_receive_handler() {
-  if (m_state != State::JOINING && m_state != State::CONNECTED)
+void Gossip::m_send_datagram(const udp::endpoint &t_destination, const string t_data) {
+  if (m_transport->local(t_destination)) {
+    m_transport->send(t_destination, make_shared<string>(t_data));
     return;
+  }
+
+  auto &queue = m_egress[t_destination];
+  if (queue.size() >= (size_t)max_output_messages()) {
+    m_instruments.egress_full->add();
+    Trace::record(Event::DROP, t_destination, uuid{}, 0, t_data.size());
+    BOOST_LOG_TRIVIAL(warning) << "Gossip::m_send_datagram:"
+                               << "\t[address]:" << t_destination
+                               << "\t egress queue full";
+    return;
+  }
+
+  queue.push_back(make_shared<string>(t_data));
+  m_drain();
+}
+
+void Gossip::m_drain() {
+  // Round-robin one datagram per destination per pass, so a backlog towards
+  // one slow peer neither starves the others nor bursts into the kernel.
+  auto now = m_clock->now();
+  auto wake = steady_clock::time_point::max();
+  for (bool progress = true; progress;) {
+    progress = false;
+    for (auto it = m_egress.begin(); it != m_egress.end();) {
+      auto &[destination, queue] = *it;
+      if (!m_pacer.admit(destination, queue.front()->size(), now)) {
+        wake = std::min(wake, m_pacer.ready(destination, queue.front()->size(), now));
+        ++it;
+        continue;
+      }
+
+      auto data = queue.front();
+      queue.pop_front();
+      auto peer = m_peer_instruments.find(destination);
+      if (peer != m_peer_instruments.end())
+        peer->second.sent->add(data->size());
+      m_transport->send(destination, data);
+      progress = true;
+      it = queue.empty() ? m_egress.erase(it) : std::next(it);
+    }
+  }
 
-  m_temp_recv_buffer.clear();
-  m_socket.async_receive_from(
-      dynamic_buffer(m_temp_recv_buffer).prepare(max_output_messages()),
-      m_temp_sender,
-      [this](const error_code ec, const size_t length) {
-        if (ec) {
-          BOOST_LOG_TRIVIAL(error) << "Gossip::m_receive_handler:"
-                                   << "\t[address]:" << ec.message();
+  if (m_egress.empty() || (m_pacing && m_pace_at <= wake))
+    return;
+
+  m_pacing = true;
+  m_pace_at = wake;
+  m_clock->schedule(wake, [this, wake]() {
+    if (!m_pacing || m_pace_at != wake)
+      return;
+    m_pacing = false;
+    m_drain();
+  });
+}
 
-          return;
-        }
+Error Gossip::reassemble(const Member t_sender,
+                         const uint32_t t_transfer,
+                         const uint32_t t_index,
+                         const uint32_t t_count,
+                         const string &t_bytes) {
+  // No sender splits a message into more parts than the reassembly buffer could hold at full size.
+  auto max_count = (m_fragments.limit() + fragment_size() - 1) / std::max(fragment_size(), 1);
+  if (t_count > max_count)
+    return Error::INVALID_MESSAGE;
+
+  auto now = m_clock->now();
+  auto data = m_fragments.insert(t_sender.address(), t_transfer, t_index, t_count, t_bytes,
+                                 now + milliseconds(message_retry_interval()),
+                                 now + m_detector.timeout(t_sender.address()));
+  if (!data)
+    return Error::NONE;
+
+  return m_receive(*data, t_sender);
+}
+
+Error Gossip::retransmit(const Member t_sender, const uint32_t t_transfer, const vector<bool> &t_missing) {
+  m_pacer.loss(t_sender.address());
+  auto parts = m_fragments.resend(t_transfer, t_missing);
+  if (parts.empty())
+    return Error::NOT_FOUND;
+
+  m_instruments.retransmits->add(parts.size());
+  Trace::record(Event::RETRANSMIT, t_sender.address(), t_sender.uid(), t_transfer, parts.size());
+  for (const auto &[index, bytes] : parts) {
+    Message::shared_ptr fragment = make_shared<Fragment>(t_transfer, index, t_missing.size(), bytes);
+    m_send_datagram(t_sender.address(), to_string(fragment));
+  }
+  return Error::NONE;
+}
 
-        m_receive(m_temp_recv_buffer.substr(0, length), m_temp_sender);
-      });
+void Gossip::m_request_fragments() {
+  for (auto &nack : m_fragments.tick(m_clock->now(), milliseconds(gossip_tick_interval())))
+    enqueue_message(Nack{nack.transfer, nack.missing}, Spreading::DIRECT, make_shared<Member>(nack.peer));
+}
+
+void Gossip::m_probe_members() {
+  auto now = m_clock->now();
+  for (auto it = m_tombstones.begin(); it != m_tombstones.end();) {
+    if (it->second.expiry >= now) {
+      ++it;
+      continue;
+    }
+    // By now every member has long applied the removes of its set elements, so their context can go.
+    m_crdts.forget(it->first);
+    it = m_tombstones.erase(it);
+  }
+
+  vector<Member::shared_ptr> targets;
+  for (const auto &peer : m_detector.expired(now)) {
+    m_pacer.loss(peer);
+    auto it = find_if(m_memberlist.begin(), m_memberlist.end(), [&peer](const Member::shared_ptr &member) {
+      return member->address() == peer;
+    });
+    if (it == m_memberlist.end()) {
+      m_detector.forget(peer);
+      continue;
+    }
+
+    if (m_detector.failures(peer) < (uint32_t)message_retry_attempts()) {
+      Trace::record(Event::SUSPECT, peer, (*it)->uid(), 0, 0, m_detector.failures(peer));
+      targets.push_back(*it);
+      continue;
+    }
+
+    Trace::record(Event::FAIL, peer, (*it)->uid(), 0, 0, m_detector.failures(peer));
+
+    BOOST_LOG_TRIVIAL(info) << "Gossip::m_probe_members:"
+                            << "\t[failed]:" << peer;
+    m_detector.forget(peer);
+    m_pacer.forget(peer);
+    m_egress.erase(peer);
+    bury(**it);
+  }
+
+  // A suspect is re-probed immediately; healthy members are probed one per interval.
+  if (now >= m_probe_at) {
+    vector<Member::shared_ptr> idle;
+    copy_if(m_memberlist.begin(), m_memberlist.end(), back_inserter(idle), [this](const Member::shared_ptr &member) {
+      return !m_detector.probing(member->address());
+    });
+    m_probe_at = now + milliseconds(probe_interval());
+    sample(idle.begin(), idle.end(), back_inserter(targets), 1, m_random);
+  }
+
+  for (const auto &target : targets) {
+    uint32_t probe = next_sequence();
+    m_detector.sent(target->address(), probe, now);
+    Trace::record(Event::PROBE, target->address(), target->uid(), probe, 0);
+    enqueue_message(Ping{probe, self_member()}, Spreading::DIRECT, target);
+  }
+}
+
+void Gossip::m_disseminate() {
+  if (m_rumors.empty() && m_obituaries.empty())
+    return;
+
+  auto collect = [](map<Member::shared_ptr, int32_t> &t_rumors) {
+    vector<Member> members;
+    for (auto it = t_rumors.begin(); it != t_rumors.end();) {
+      members.push_back(*it->first);
+      it = --it->second > 0 ? std::next(it) : t_rumors.erase(it);
+    }
+    return members;
+  };
+  auto members = collect(m_rumors);
+  auto dead = collect(m_obituaries);
+
+  for (const auto &peer : peers(fanout())) {
+    if (!members.empty())
+      enqueue_message(Memberlist{members}, Spreading::DIRECT, peer);
+    if (!dead.empty())
+      enqueue_message(Obituary{dead}, Spreading::DIRECT, peer);
+  }
+}
+
+void Gossip::m_adapt_tick() {
+  // Halve the tick while there is dissemination or request work in flight and
+  // double it back while idle; replies never wait for it since m_flush sends them.
+  auto min = milliseconds(min_tick_interval());
+  auto max = milliseconds(std::max(max_tick_interval(), min_tick_interval()));
+  if (m_tick == steady_clock::duration{})
+    m_tick = milliseconds(gossip_tick_interval());
+
+  bool busy = !m_rumors.empty() || !m_obituaries.empty() || !m_pending.empty() || m_state == State::JOINING;
+  m_tick = std::clamp<steady_clock::duration>(busy ? m_tick / 2 : m_tick * 2, min, max);
+}
+
+void Gossip::m_instrument() {
+  m_instruments.invalid = &m_metrics.counter("gossip_invalid_messages_total", "Datagrams that failed to decode");
+  m_instruments.egress_full = &m_metrics.counter("gossip_dropped_total", "Outbound datagrams or messages given up on",
+                                                 "reason=\"egress_full\"");
+  m_instruments.abandoned = &m_metrics.counter("gossip_dropped_total", "Outbound datagrams or messages given up on",
+                                               "reason=\"attempts\"");
+  m_instruments.retransmits = &m_metrics.counter("gossip_retransmits_total", "Fragments resent after a NACK");
+  m_instruments.hits = &m_metrics.counter("gossip_cache_hits_total", "Reads answered from a cache", "cache=\"local\"");
+  m_instruments.misses = &m_metrics.counter("gossip_cache_misses_total", "Reads a cache could not answer", "cache=\"local\"");
+  m_instruments.near_hits = &m_metrics.counter("gossip_cache_hits_total", "Reads answered from a cache", "cache=\"near\"");
+  m_instruments.near_misses = &m_metrics.counter("gossip_cache_misses_total", "Reads a cache could not answer", "cache=\"near\"");
+  m_instruments.evictions = &m_metrics.counter("gossip_cache_evictions_total", "Entries dropped without a delete",
+                                               "cache=\"local\"");
+  m_instruments.near_evictions = &m_metrics.counter("gossip_cache_evictions_total", "Entries dropped without a delete",
+                                                    "cache=\"near\"");
+  m_instruments.requests = &m_metrics.latency("gossip_request_seconds", "Round trip of forwarded requests");
+  m_instruments.members = &m_metrics.gauge("gossip_members", "Members in the memberlist");
+  m_instruments.outbound = &m_metrics.gauge("gossip_queue_depth", "Items waiting in a queue", "queue=\"messages\"");
+  m_instruments.egress = &m_metrics.gauge("gossip_queue_depth", "Items waiting in a queue", "queue=\"egress\"");
+  m_instruments.pending = &m_metrics.gauge("gossip_queue_depth", "Items waiting in a queue", "queue=\"pending\"");
+  m_instruments.rumors = &m_metrics.gauge("gossip_queue_depth", "Items waiting in a queue", "queue=\"rumors\"");
+  m_instruments.entries = &m_metrics.gauge("gossip_cache_entries", "Entries held by this member");
+  m_instruments.crdts = &m_metrics.gauge("gossip_crdt_keys", "Counters, registers and sets held by this member");
+}
+
+void Gossip::m_sample() {
+  // Levels are copied once per tick so readers on other threads never touch the containers.
+  size_t egress = 0;
+  for (const auto &[destination, queue] : m_egress)
+    egress += queue.size();
+
+  m_instruments.members->set(m_memberlist.size());
+  m_instruments.outbound->set(m_message.size());
+  m_instruments.egress->set(egress);
+  m_instruments.pending->set(m_pending.size());
+  m_instruments.rumors->set(m_rumors.size() + m_obituaries.size());
+  m_instruments.entries->set(m_cache.size());
+  m_instruments.crdts->set(m_crdts.size());
+  m_instruments.near_evictions->add(m_near_cache.evictions() - m_near_evictions);
+  m_near_evictions = m_near_cache.evictions();
+}
+
+const Gossip::TypeInstruments &Gossip::m_type(std::unordered_map<type_index, TypeInstruments> &t_types,
+                                              const string &t_name,
+                                              const type_index t_type) {
+  // Demangled once per message type; afterwards a hash lookup.
+  auto &instruments = t_types[t_type];
+  if (!instruments.count) {
+    auto type = demangle(t_type.name());
+    type = type.substr(type.rfind(':') + 1);
+    instruments.count = &m_metrics.counter(t_name, "Messages by type", "type=\"" + type + "\"");
+    instruments.trace = Trace::intern(type);
+  }
+  return instruments;
+}
+
+void Gossip::m_transition(const State t_state) {
+  Trace::record(Event::STATE, self_member()->address(), self_member()->uid(), (uint32_t)m_state, 0, (uint32_t)t_state);
+  m_state = t_state;
+}
+
+void Gossip::m_hasten() {
+  // Cuts the current tick short so new dissemination work starts right away.
+  m_tick = milliseconds(min_tick_interval());
+  m_tick_at = std::min(m_tick_at, m_clock->now() + m_tick);
+  m_context.stop();
+}
+
+void Gossip::m_flush() {
+  if (m_flushing)
+    return;
+
+  m_flushing = true;
+  boost::asio::post(m_context, [this]() {
+    m_flushing = false;
+    m_send_handler();
+  });
+}
+
+size_t Gossip::fanout() const {
+  size_t members = m_memberlist.size();
+  return std::min<size_t>(members, std::ceil(std::log2(members + 1)));
+}
+
+int32_t Gossip::retransmits() const {
+  return message_rumor_factor() * (int32_t)std::ceil(std::log10(m_memberlist.size() + 1));
+}
+
+Error Gossip::acknowledge(const Member t_sender, const uint32_t t_probe) {
+  auto ping = m_pings.extract(t_probe);
+  if (!ping.empty()) {
+    ping.mapped()(Error::NONE);
+    return Error::NONE;
+  }
+
+  if (!m_detector.acked(t_sender.address(), t_probe, m_clock->now()))
+    return Error::NOT_FOUND;
+  Trace::record(Event::ACK, t_sender.address(), t_sender.uid(), t_probe, 0);
+  m_pacer.success(t_sender.address());
+  return Error::NONE;
+}
+
+void Gossip::advertise(const Member t_member, const uint32_t t_codecs, const uint32_t t_dictionaries) {
+  uint32_t capabilities = t_codecs & Codec::capabilities;
+  if (t_dictionaries && t_dictionaries == m_codec.dictionaries())
+    capabilities |= Codec::shared_dictionaries;
+  m_capabilities[t_member.address()] = capabilities;
+}
+
+void Gossip::m_train_codec() {
+  // Dictionaries must be byte-identical on every member, so the samples are
+  // built from fixed uids, addresses and keys rather than from live state.
+  vector<Member> members;
+  for (int i = 1; i <= 16; ++i)
+    members.emplace_back(uuid{}, udp::endpoint(address::from_string("10.0.0." + std::to_string(i)), 7777));
+  auto destination = make_shared<Member>(members.front());
+  Message::Header header(1, message_retry_attempts(), destination);
+
+  Cache::Entry entry{string(32, 'v'), 1};
+  vector<string> keys;
+  vector<pair<string, string>> items;
+  vector<Result> results;
+  Cache::Range range;
+  vector<Digest::Node> nodes;
+  for (uint32_t i = 0; i < 16; ++i) {
+    keys.push_back("key:" + std::to_string(i));
+    items.emplace_back(keys.back(), entry.value);
+    results.emplace_back(Error::NONE, entry);
+    range.emplace_back(keys.back(), entry);
+    nodes.emplace_back(i, i, 0x9e3779b97f4a7c15ull * (i + 1));
+  }
+
+  auto train = [this](const Message::shared_ptr t_sample) {
+    m_codec.train(type_index(typeid(*t_sample)), to_string(t_sample));
+  };
+  train(make_shared<Hello>(header, destination));
+  train(make_shared<Welcome>(destination));
+  train(make_shared<Memberlist>(members));
+  train(make_shared<Roster>(roster(), true));
+  train(make_shared<Obituary>(members));
+  train(make_shared<Get>(header, keys.front(), 0));
+  train(make_shared<message::Set>(header, keys.front(), entry.value, 0));
+  train(make_shared<Value>(1, Error::NONE, entry));
+  train(make_shared<MultiGet>(header, keys, 0));
+  train(make_shared<MultiSet>(header, items, 0));
+  train(make_shared<MultiValue>(1, results));
+  train(make_shared<Digest>(0, nodes));
+  train(make_shared<Entries>(0, 0, range, false));
+  train(make_shared<Invalidate>(keys));
+
+  Crdts crdts;
+  for (const auto &key : keys)
+    crdts.increment(key);
+  train(make_shared<Delta>(crdts.snapshot()));
+  train(make_shared<Summary>(crdts.root(), 1, crdts.digest()));
+}
+
+Error Gossip::deliver(const string t_data, const Member t_sender) { return m_receive(t_data, t_sender); }
+
+void Gossip::m_receive_handler() {
+  if (m_state != State::JOINING && m_state != State::CONNECTED)
+    return;
+
+  // Replies only need the sender's address; a nil uid keeps them byte-identical between runs.
+  m_transport->receive([this](const udp::endpoint &t_sender, const string &t_data) {
+    m_receive(t_data, Member(uuid{}, t_sender));
+  });
 }
 
 void Gossip::m_send_handler() {
@@ -181,12 +1424,13 @@ void Gossip::m_send_handler() {
     return;
 
   while (!this->m_message.empty()) {
-    BOOST_LOG_TRIVIAL(trace) << "Gossip::m_send_handler:"
-                             << "\t -> " << demangle(typeid(**m_message.begin()).name());
-    Message message = **m_message.begin();
+    const auto &message = **m_message.begin();
     if (message.m_header.remain_attempt <= 0) {
+      m_instruments.abandoned->add();
+      Trace::record(Event::DROP, message.m_header.destination->address(), message.m_header.destination->uid(),
+                    message.m_header.sequence, 0);
       if (message_retry_attempts() > 1) {
-        m_memberlist.erase(message.m_header.destination);
+        erase_member(message.m_header.destination);
       }
 
       this->m_message.erase(this->m_message.begin());
@@ -197,7 +1441,10 @@ void Gossip::m_send_handler() {
     this->m_message.erase(this->m_message.begin());
   }
 
-  return;
+  auto flushed = std::move(m_flushed);
+  m_flushed.clear();
+  for (auto &resume : flushed)
+    resume(Error::NONE);
 }
 
 int32_t &Gossip::message_retry_interval() { return m_message_retry_interval; }
@@ -215,8 +1462,85 @@ const int32_t &Gossip::message_max_size() const { return m_message_max_size; }
 int32_t &Gossip::max_output_messages() { return m_max_output_messages; }
 const int32_t &Gossip::max_output_messages() const { return m_max_output_messages; }
 
+int32_t &Gossip::join_interval() { return m_join_interval; }
+const int32_t &Gossip::join_interval() const { return m_join_interval; }
+
 int32_t &Gossip::gossip_tick_interval() { return m_gossip_tick_interval; }
 const int32_t &Gossip::gossip_tick_interval() const { return m_gossip_tick_interval; }
 
+int32_t &Gossip::min_tick_interval() { return m_min_tick_interval; }
+const int32_t &Gossip::min_tick_interval() const { return m_min_tick_interval; }
+
+int32_t &Gossip::max_tick_interval() { return m_max_tick_interval; }
+const int32_t &Gossip::max_tick_interval() const { return m_max_tick_interval; }
+
+int32_t &Gossip::max_forward_hops() { return m_max_forward_hops; }
+const int32_t &Gossip::max_forward_hops() const { return m_max_forward_hops; }
+
+int32_t &Gossip::replication_factor() { return m_replication_factor; }
+const int32_t &Gossip::replication_factor() const { return m_replication_factor; }
+
+int32_t &Gossip::anti_entropy_interval() { return m_anti_entropy_interval; }
+const int32_t &Gossip::anti_entropy_interval() const { return m_anti_entropy_interval; }
+
+int32_t &Gossip::fragment_size() { return m_fragment_size; }
+const int32_t &Gossip::fragment_size() const { return m_fragment_size; }
+
+int32_t &Gossip::stream_threshold() { return m_stream_threshold; }
+const int32_t &Gossip::stream_threshold() const { return m_stream_threshold; }
+
+double &Gossip::cross_zone_probability() { return m_cross_zone_probability; }
+const double &Gossip::cross_zone_probability() const { return m_cross_zone_probability; }
+
+int32_t &Gossip::probe_interval() { return m_probe_interval; }
+const int32_t &Gossip::probe_interval() const { return m_probe_interval; }
+
+int32_t &Gossip::tombstone_ttl() { return m_tombstone_ttl; }
+const int32_t &Gossip::tombstone_ttl() const { return m_tombstone_ttl; }
+
+int32_t &Gossip::hot_key_threshold() { return m_hot_key_threshold; }
+const int32_t &Gossip::hot_key_threshold() const { return m_hot_key_threshold; }
+
+int32_t &Gossip::hot_key_window() { return m_hot_key_window; }
+const int32_t &Gossip::hot_key_window() const { return m_hot_key_window; }
+
+int32_t &Gossip::near_cache_ttl() { return m_near_cache_ttl; }
+const int32_t &Gossip::near_cache_ttl() const { return m_near_cache_ttl; }
+
+bool &Gossip::invalidate_reads() { return m_invalidate_reads; }
+const bool &Gossip::invalidate_reads() const { return m_invalidate_reads; }
+
+Gossip::LoaderFn &Gossip::loader() { return m_loader; }
+const Gossip::LoaderFn &Gossip::loader() const { return m_loader; }
+
+Gossip::MembershipFn &Gossip::membership_listener() { return m_membership_listener; }
+const Gossip::MembershipFn &Gossip::membership_listener() const { return m_membership_listener; }
+
+Gossip::InvalidationFn &Gossip::invalidation_listener() { return m_invalidation_listener; }
+const Gossip::InvalidationFn &Gossip::invalidation_listener() const { return m_invalidation_listener; }
+
+State Gossip::state() const { return m_state; }
+
 const Member::shared_ptr &Gossip::self_member() const { return m_self_member; }
+const std::set<Member::shared_ptr> &Gossip::memberlist() const { return m_memberlist; }
+const Member::shared_ptr &Gossip::owner(const uint32_t t_partition) const { return m_owners[t_partition]; }
+const vector<Member::shared_ptr> &Gossip::replicas(const uint32_t t_partition) const { return m_replicas[t_partition]; }
+bool Gossip::replicates(const uint32_t t_partition) const {
+  const auto &replicas = m_replicas[t_partition];
+  return find(replicas.begin(), replicas.end(), self_member()) != replicas.end();
+}
+Clock &Gossip::clock() { return *m_clock; }
+Codec &Gossip::codec() { return m_codec; }
+Detector &Gossip::detector() { return m_detector; }
+Pacer &Gossip::pacer() { return m_pacer; }
+
+Cache &Gossip::cache() { return m_cache; }
+shared_ptr<Transport> &Gossip::transport() { return m_transport; }
+NearCache &Gossip::near_cache() { return m_near_cache; }
+
+Crdts &Gossip::crdts() { return m_crdts; }
+Metrics &Gossip::metrics() { return m_metrics; }
+Migration &Gossip::migration() { return m_migration; }
+io_context &Gossip::context() { return m_context; }
+uint32_t Gossip::next_sequence() { return ++m_sequence; }
 }; // namespace gossip
\ No newline at end of file
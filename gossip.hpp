@@ -6,12 +6,32 @@
 #include <deque>
 #include <functional>
 #include <future>
+#include <map>
 #include <memory>
+#include <optional>
+#include <random>
+#include <typeindex>
+#include <unordered_map>
 #include <vector>
 
+#include "cache.hpp"
+#include "clock.hpp"
+#include "codec.hpp"
+#include "completion.hpp"
+#include "crdt.hpp"
+#include "detector.hpp"
+#include "flight.hpp"
+#include "fragment.hpp"
+#include "hotkeys.hpp"
 #include "member.hpp"
 #include "message.hpp"
+#include "metrics.hpp"
+#include "migration.hpp"
+#include "pacer.hpp"
+#include "trace.hpp"
+#include "transport.hpp"
 
+using boost::asio::awaitable;
 using boost::asio::io_context;
 using boost::asio::ip::address;
 using boost::asio::ip::port_type;
@@ -22,11 +42,14 @@ using gossip::message::IMessages_Ptr;
 using gossip::message::Message;
 using std::async;
 using std::future;
+using std::map;
+using std::optional;
 using std::set;
 using std::shared_future;
 using std::shared_ptr;
 using std::string;
 using std::thread;
+using std::vector;
 
 namespace gossip {
 enum class Error : int32_t {
@@ -57,39 +80,204 @@ enum class Spreading {
 };
 
 class Gossip {
+public:
+  typedef Completion<const Error, const optional<Cache::Entry>> ValueFn;
+  typedef std::pair<Error, optional<Cache::Entry>> Result;
+  typedef Completion<const vector<Result>> MultiFn;
+  typedef std::function<void(const optional<string>)> FillFn;
+  typedef std::function<void(const string, const FillFn)> LoaderFn;
+  typedef std::function<void(const Member::shared_ptr, const bool)> MembershipFn;
+  typedef std::function<void(const string)> InvalidationFn;
+
+private:
   typedef std::function<void(string)> ReceiverFn;
   ReceiverFn m_receiver;
+  LoaderFn m_loader;
+  MembershipFn m_membership_listener;
+  InvalidationFn m_invalidation_listener;
+
+  struct Pending {
+    ValueFn callback;
+    Completion<const optional<vector<Result>>> batch;
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::steady_clock::time_point started;
+  };
+
+  /** The series the hot paths update, registered up front so recording is one relaxed add. */
+  struct Instruments {
+    Counter *invalid;
+    Counter *egress_full;
+    Counter *abandoned;
+    Counter *retransmits;
+    Counter *hits;
+    Counter *misses;
+    Counter *near_hits;
+    Counter *near_misses;
+    Counter *evictions;
+    Counter *near_evictions;
+    Latency *requests;
+    Gauge *members;
+    Gauge *outbound;
+    Gauge *egress;
+    Gauge *pending;
+    Gauge *rumors;
+    Gauge *entries;
+    Gauge *crdts;
+  };
+
+  /** What a message type is counted and traced as, resolved once per type. */
+  struct TypeInstruments {
+    Counter *count;
+    uint32_t trace;
+  };
+
+  /** Partition owners and replica sets, owner first, as placed over some set of members. */
+  struct Placement {
+    vector<Member::shared_ptr> owners;
+    vector<vector<Member::shared_ptr>> replicas;
+  };
+
+  /** Traffic series of one known member, dropped together with it. */
+  struct PeerInstruments {
+    Counter *sent;
+    Counter *received;
+  };
+
+  /** A member reported failed, kept so that stale reports of it being alive are ignored. */
+  struct Tombstone {
+    Member member;
+    std::chrono::steady_clock::time_point expiry;
+  };
 
   int32_t m_message_retry_interval = 10000;
   int32_t m_message_retry_attempts = 3;
   int32_t m_message_rumor_factor = 3;
-  int32_t m_message_max_size = 65535;
+  int32_t m_message_max_size = 65507;
   int32_t m_max_output_messages = 65535;
+  int32_t m_join_interval = 250;
   int32_t m_gossip_tick_interval = 500;
+  int32_t m_min_tick_interval = 20;
+  int32_t m_max_tick_interval = 1000;
+  int32_t m_max_forward_hops = 4;
+  int32_t m_replication_factor = 2;
+  int32_t m_anti_entropy_interval = 1000;
+  int32_t m_hot_key_threshold = 1000;
+  int32_t m_hot_key_window = 1000;
+  int32_t m_near_cache_ttl = 2000;
+  bool m_invalidate_reads = false;
+  int32_t m_fragment_size = 8192;
+  int32_t m_stream_threshold = 1 << 20;
+  int32_t m_probe_interval = 1000;
+  int32_t m_tombstone_ttl = 60000;
+  double m_cross_zone_probability = 0.1;
 
   State m_state = State::INITIALIZED;
   Member::shared_ptr m_self_member;
-  set<Member::shared_ptr> m_memberlist;
-  set<Message::shared_ptr> m_message;
+  std::set<Member::shared_ptr> m_memberlist;
+  vector<Member::shared_ptr> m_seeds;
+  std::chrono::steady_clock::time_point m_join_at;
+  std::set<Message::shared_ptr> m_message;
 
-  io_context m_context;
-  udp::socket m_socket = udp::socket(m_context);
+  Cache m_cache;
+  vector<Member::shared_ptr> m_owners;
+  vector<vector<Member::shared_ptr>> m_replicas;
+  std::chrono::steady_clock::time_point m_anti_entropy_at;
+  uint32_t m_sequence = 0;
+  map<uint32_t, Pending> m_pending;
+  map<uint32_t, Completion<const Error>> m_pings;
+  /** Resumed once the send handler has drained the messages enqueued before them. */
+  vector<Completion<const Error>> m_flushed;
+  SingleFlight<string, Error, optional<Cache::Entry>> m_flights;
+  HotKeys m_hot_keys;
+  NearCache m_near_cache;
+  Crdts m_crdts;
+  std::chrono::steady_clock::time_point m_hot_keys_at;
+  Fragments m_fragments;
+  Codec m_codec;
+  map<udp::endpoint, uint32_t> m_capabilities;
+  Detector m_detector;
+  Pacer m_pacer;
+  std::chrono::steady_clock::time_point m_probe_at;
+  std::chrono::steady_clock::time_point m_tick_at;
+  std::chrono::steady_clock::duration m_tick{};
+  map<Member::shared_ptr, int32_t> m_rumors;
+  map<Member::shared_ptr, int32_t> m_obituaries;
+  map<uuid, Tombstone> m_tombstones;
+  bool m_flushing = false;
 
-  string m_temp_recv_buffer;
-  udp::endpoint m_temp_sender;
+  io_context m_context;
+  shared_ptr<Transport> m_transport;
+  shared_ptr<Clock> m_clock;
+  std::mt19937 m_random{std::random_device{}()};
+  Migration m_migration{*this};
+  map<udp::endpoint, std::deque<shared_ptr<string>>> m_egress;
+  std::chrono::steady_clock::time_point m_pace_at;
+  bool m_pacing = false;
+  Metrics m_metrics;
+  Instruments m_instruments{};
+  std::unordered_map<std::type_index, TypeInstruments> m_received;
+  std::unordered_map<std::type_index, TypeInstruments> m_sent;
+  map<udp::endpoint, PeerInstruments> m_peer_instruments;
+  uint64_t m_near_evictions = 0;
 
   void m_receive_handler();
   void m_send_handler();
   Error m_receive(const string t_data, const Member t_sender);
+  awaitable<void> m_handle(const Message::shared_ptr t_message, const Member t_sender);
   template <IMessages_Ptr IMessage_Ptr>
   Error m_send(IMessage_Ptr t_message);
+  void m_send_datagram(const udp::endpoint &t_destination, const string t_data);
+  void m_drain();
+  void m_request_fragments();
+  void m_train_codec();
+  void m_probe_members();
+  void m_disseminate();
+  void m_adapt_tick();
+  void m_hasten();
+  void m_flush();
+  void m_rebalance();
+  Placement m_place(const vector<Member::shared_ptr> &t_members) const;
+  bool m_insert_member(const Member::shared_ptr t_member, const bool t_rumor);
+  void m_greet_seeds();
+  void m_expire_pending();
+  void m_anti_entropy();
+  void m_announce_hot_keys();
+  void m_spread_deltas();
+  Member::shared_ptr m_route(const uint32_t t_partition) const;
+  void m_forward(const Member::shared_ptr t_target, Message::shared_ptr t_message, ValueFn t_callback);
+  void m_forward(const Member::shared_ptr t_target, Message::shared_ptr t_message, Pending t_pending);
+  void m_fill(const string t_key);
+  void m_instrument();
+  void m_sample();
+  const TypeInstruments &m_type(std::unordered_map<std::type_index, TypeInstruments> &t_types,
+                                const string &t_name,
+                                const std::type_index t_type);
+  void m_transition(const State t_state);
 
 public:
   Gossip() = default;
   Gossip(const Member t_self_member, const ReceiverFn t_receiver);
 
+  /** A node on a custom datagram transport and clock; partition migration over TCP stays off. */
+  Gossip(const Member t_self_member,
+         const ReceiverFn t_receiver,
+         const shared_ptr<Transport> t_transport,
+         const shared_ptr<Clock> t_clock);
+
   void run();
 
+  /** Ends `run` after the current round; call it on the node's context. */
+  void stop();
+
+  /** Runs one round of periodic work; `run` calls it on wall-clock time, a simulation on virtual time. */
+  void tick();
+
+  /** When the next `tick` is due. */
+  const std::chrono::steady_clock::time_point &next_tick() const;
+
+  /** Reseeds the generator behind every random peer choice, for reproducible runs. */
+  void seed(const uint32_t t_seed);
+
   template <typename Streamable>
   future<Error> send(const Streamable data);
 
@@ -98,8 +286,135 @@ public:
                         const Spreading t_spreading,
                         const Member::shared_ptr t_member = nullptr);
 
+  /** Enqueues like `enqueue_message` and resumes once the send handler has put the message on the transport. */
+  template <IMessages IMessage>
+  awaitable<Error> async_enqueue_message(const IMessage t_message,
+                                         const Spreading t_spreading,
+                                         const Member::shared_ptr t_member = nullptr);
+
+  /**
+   * Greets a seed with a Hello, resent every `join_interval` until one answers.
+   * All seeds are greeted at once and the first complete Welcome is applied, so
+   * call it for every seed before `run`. A seed at this member's own address is
+   * skipped; with no other seed the member starts a cluster of its own.
+   */
   Error add_member(const Member t_member);
 
+  /**
+   * Applies the memberlist and CRDT state of a seed's Welcome in one step and
+   * moves to CONNECTED. Later answers from other seeds only add the members
+   * not known yet, one at a time like a rumor would.
+   */
+  Error join(const vector<Member> &t_members, const Crdts::Batch &t_crdts);
+
+  /** Answers a joining member with this member's memberlist and CRDT state, over the stream when there is one. */
+  void welcome(const Member::shared_ptr t_member);
+
+  /** Records a member learned from the cluster and rebalances partition ownership. */
+  Error insert_member(const Member::shared_ptr t_member);
+  Error erase_member(const Member::shared_ptr t_member);
+
+  /**
+   * Removes a member reported failed at the given incarnation, keeps a tombstone
+   * for `tombstone_ttl` so it is not re-inserted from peers that have not heard
+   * yet, and spreads the report like a rumor. A report about this member is
+   * refuted instead, by raising its incarnation and announcing itself. When the
+   * tombstone expires, the CRDT sets forget the member's causal context.
+   */
+  Error bury(const Member t_member);
+
+  /** The member as it was reported failed, if a tombstone for the uid is still kept. */
+  optional<Member> tombstone(const uuid &t_uid) const;
+
+  /**
+   * Reads a key from its owner, forwarding when the owner is remote or the partition is in transit.
+   * Concurrent reads of one key share a single forward or loader call.
+   */
+  void get(const string t_key, ValueFn t_callback, const uint32_t t_hops = 0);
+  void set(const string t_key, const string t_value, ValueFn t_callback, const uint32_t t_hops = 0);
+
+  /**
+   * Reads many keys with one batched request per owning member, sent in parallel.
+   * Results keep the order of `t_keys`; keys whose owner does not answer fail individually.
+   */
+  void mget(const vector<string> t_keys, MultiFn t_callback, const uint32_t t_hops = 0);
+  void mset(const vector<pair<string, string>> t_items, MultiFn t_callback, const uint32_t t_hops = 0);
+
+  /**
+   * The coroutine forms of `get`, `set`, `mget` and `mset`, for handlers on this
+   * node's context. A forwarded request parks the caller's completion handler in
+   * its Pending entry and resumes it inline once the reply arrives or the
+   * deadline passes, with no thread held in between.
+   */
+  awaitable<Result> async_get(const string t_key, const uint32_t t_hops = 0);
+  awaitable<Result> async_set(const string t_key, const string t_value, const uint32_t t_hops = 0);
+  awaitable<vector<Result>> async_mget(const vector<string> t_keys, const uint32_t t_hops = 0);
+  awaitable<vector<Result>> async_mset(const vector<pair<string, string>> t_items, const uint32_t t_hops = 0);
+
+  /** Probes a member; resumes with NONE once it acknowledges or READ_FAILED after `t_timeout`. */
+  awaitable<Error> async_ping(const Member::shared_ptr t_member, const std::chrono::milliseconds t_timeout);
+
+  /** Resumes with NONE once the `Ack` of probe `t_probe` arrives, or READ_FAILED after `t_timeout`. */
+  awaitable<Error> async_acknowledged(const uint32_t t_probe, const std::chrono::milliseconds t_timeout);
+
+  /** Drops keys another member reported changed from the near cache and tells the invalidation listener. */
+  void invalidate(const vector<string> &t_keys);
+
+  /** Completes a forwarded request once its `Value` reply arrives. */
+  Error complete(const uint32_t t_request, const Error t_error, const optional<Cache::Entry> t_entry);
+  Error complete(const uint32_t t_request, const vector<Result> t_results);
+
+  /** Stores one fragment of an oversized message and dispatches the message once it is whole. */
+  Error reassemble(const Member t_sender,
+                   const uint32_t t_transfer,
+                   const uint32_t t_index,
+                   const uint32_t t_count,
+                   const string &t_bytes);
+
+  /** Resends the fragments of one of our transfers that a peer reported missing. */
+  Error retransmit(const Member t_sender, const uint32_t t_transfer, const vector<bool> &t_missing);
+
+  /** Completes a probe once its `Ack` arrives and updates the sender's round-trip estimate. */
+  Error acknowledge(const Member t_sender, const uint32_t t_probe);
+
+  /** Records the Compression bits a member can decode and whether it shares our dictionaries, as advertised in its Hello or Welcome. */
+  void advertise(const Member t_member, const uint32_t t_codecs, const uint32_t t_dictionaries);
+
+  /**
+   * Dispatches a serialized message that arrived outside the UDP socket and
+   * returns the handler's result; a request that waits on another member is
+   * accepted with NONE and answers the sender later.
+   */
+  Error deliver(const string t_data, const Member t_sender);
+
+  /** Up to `t_count` random members, preferring this member's zone; the targets of RANDOM spreading. */
+  vector<Member::shared_ptr> peers(const size_t t_count);
+
+  /** The member owning a partition under the current membership. */
+  const Member::shared_ptr &owner(const uint32_t t_partition) const;
+
+  /** The members holding a copy of a partition, owner first. */
+  const vector<Member::shared_ptr> &replicas(const uint32_t t_partition) const;
+  bool replicates(const uint32_t t_partition) const;
+
+  /** An order-independent hash of the member uids this node knows, itself included. */
+  uint64_t membership_digest() const;
+
+  /** The uids of this member and every member it knows, exchanged to find which ones a peer lacks. */
+  vector<uuid> roster() const;
+
+  /** Sends Merkle nodes to a replica for comparison, split to fit the message size. */
+  void send_digest(const Member::shared_ptr t_member,
+                   const uint64_t t_membership,
+                   const vector<message::Digest::Node> &t_nodes);
+
+  /** Sends the entries of one Merkle leaf to a replica, split to fit the message size. */
+  void send_entries(const Member::shared_ptr t_member,
+                    const uint32_t t_partition,
+                    const uint32_t t_leaf,
+                    const Cache::Range &t_entries,
+                    const bool t_reply);
+
   /** The interval in milliseconds between retry attempts. */
   int32_t &message_retry_interval();
   const int32_t &message_retry_interval() const;
@@ -108,7 +423,7 @@ public:
   int32_t &message_retry_attempts();
   const int32_t &message_retry_attempts() const;
 
-  /** The number of members that are used for further gossip propagation. */
+  /** The multiplier of log10(n + 1) giving how many ticks a membership rumor is retransmitted for. */
   int32_t &message_rumor_factor();
   const int32_t &message_rumor_factor() const;
 
@@ -120,11 +435,120 @@ public:
   int32_t &max_output_messages();
   const int32_t &max_output_messages() const;
 
+  /** The interval in milliseconds between Hellos to the seeds while no Welcome has been applied. */
+  int32_t &join_interval();
+  const int32_t &join_interval() const;
+
   /** The time interval in milliseconds that determines how often the Gossip tick event should be triggered. */
   int32_t &gossip_tick_interval();
   const int32_t &gossip_tick_interval() const;
 
+  /** The shortest tick in milliseconds, used while rumors or forwarded requests are pending. */
+  int32_t &min_tick_interval();
+  const int32_t &min_tick_interval() const;
+
+  /** The longest tick in milliseconds the interval backs off to while idle. */
+  int32_t &max_tick_interval();
+  const int32_t &max_tick_interval() const;
+
+  /** The number of peers each rumor round is sent to, ceil(log2(n + 1)) for n known members. */
+  size_t fanout() const;
+
+  /** The number of rounds a rumor is retransmitted for at the current membership size. */
+  int32_t retransmits() const;
+
+  /** The maximum number of times a request is forwarded before it is served locally. */
+  int32_t &max_forward_hops();
+  const int32_t &max_forward_hops() const;
+
+  /** The number of members holding a copy of each partition; 0 turns partition placement off. */
+  int32_t &replication_factor();
+  const int32_t &replication_factor() const;
+
+  /** The interval in milliseconds between Merkle root exchanges with a random replica. */
+  int32_t &anti_entropy_interval();
+  const int32_t &anti_entropy_interval() const;
+
+  /** The payload size in bytes of each datagram a message above `message_max_size` is split into. */
+  int32_t &fragment_size();
+  const int32_t &fragment_size() const;
+
+  /** The serialized size in bytes above which a message is sent over the TCP stream instead of UDP. */
+  int32_t &stream_threshold();
+  const int32_t &stream_threshold() const;
+
+  /** The chance that each randomly spread message picks a peer outside this member's zone. */
+  double &cross_zone_probability();
+  const double &cross_zone_probability() const;
+
+  /** The interval in milliseconds between liveness probes to a random member. */
+  int32_t &probe_interval();
+  const int32_t &probe_interval() const;
+
+  /** How long in milliseconds a failed member is remembered; longer than a report takes to reach everyone. */
+  int32_t &tombstone_ttl();
+  const int32_t &tombstone_ttl() const;
+
+  /** The number of reads per window at which an owned key is replicated to every member's near cache. */
+  int32_t &hot_key_threshold();
+  const int32_t &hot_key_threshold() const;
+
+  /** The interval in milliseconds between hot key scans; access counts halve after each. */
+  int32_t &hot_key_window();
+  const int32_t &hot_key_window() const;
+
+  /** How long in milliseconds a hot key stays in other members' near caches. */
+  int32_t &near_cache_ttl();
+  const int32_t &near_cache_ttl() const;
+
+  /**
+   * Whether an owner also broadcasts `Invalidate` for keys it served to other
+   * members within the last `near_cache_ttl`, not only for hot keys. Needed on
+   * every member when clients keep their own near caches of arbitrary keys.
+   */
+  bool &invalidate_reads();
+  const bool &invalidate_reads() const;
+
+  /**
+   * The read-through backend consulted by the owner on a miss. It must invoke its
+   * FillFn on this Gossip's context; nullptr disables fills.
+   */
+  LoaderFn &loader();
+  const LoaderFn &loader() const;
+
+  /** Called with `true` when a member joins this node's memberlist and `false` when it is removed. */
+  MembershipFn &membership_listener();
+  const MembershipFn &membership_listener() const;
+
+  /**
+   * Called on this node's context with every key it learns was written: local
+   * and forwarded writes, `Invalidate` and `Hot` broadcasts. Repairs by anti-entropy
+   * and migration are not reported, so copies built on it still need a TTL.
+   */
+  InvalidationFn &invalidation_listener();
+  const InvalidationFn &invalidation_listener() const;
+
+  /** Where this member is in its lifecycle; CONNECTED once a seed's Welcome was applied. */
+  State state() const;
+
   const Member::shared_ptr &self_member() const;
+  const std::set<Member::shared_ptr> &memberlist() const;
+  Cache &cache();
+  Clock &clock();
+  Codec &codec();
+
+  /** The datagram path; may be replaced, e.g. wrapped in a LocalTransport, before `run`. */
+  shared_ptr<Transport> &transport();
+  Detector &detector();
+  Pacer &pacer();
+  NearCache &near_cache();
+
+  /** Counters, registers and sets every member writes locally and merges through gossip; use on the node's context. */
+  Crdts &crdts();
+  Metrics &metrics();
+  Migration &migration();
+  io_context &context();
+  uint32_t next_sequence();
 };
 }; // namespace gossip
 
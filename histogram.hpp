@@ -0,0 +1,96 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+using std::array;
+
+namespace gossip {
+
+/**
+ * A log-linear histogram of non-negative integers in the style of HdrHistogram.
+ * Values below 2^Precision are counted exactly; each higher power of two is split
+ * into 2^Precision equal sub-buckets, so any recorded value is reported within a
+ * relative error of 2^-Precision. Recording is a bit scan and an increment.
+ */
+template <uint32_t Precision>
+class Histogram {
+public:
+  static const uint32_t sub_buckets = 1u << Precision;
+  static const uint32_t bucket_count = (64 - Precision + 1) * sub_buckets;
+
+  static uint32_t index_of(const uint64_t t_value) {
+    if (t_value < sub_buckets)
+      return t_value;
+    uint32_t exponent = std::bit_width(t_value) - 1;
+    uint32_t shift = exponent - Precision;
+    return (shift + 1) * sub_buckets + (uint32_t)((t_value >> shift) - sub_buckets);
+  }
+
+  /** The largest value that lands in bucket `t_index`. */
+  static uint64_t value_of(const uint32_t t_index) {
+    if (t_index < sub_buckets)
+      return t_index;
+    uint32_t shift = t_index / sub_buckets - 1;
+    uint64_t base = (uint64_t)(sub_buckets + t_index % sub_buckets) << shift;
+    return base + ((1ull << shift) - 1);
+  }
+
+  void record(const uint64_t t_value, const uint64_t t_count = 1) {
+    m_counts[index_of(t_value)] += t_count;
+    m_total += t_count;
+    m_sum += t_value * t_count;
+    m_min = std::min(m_min, t_value);
+    m_max = std::max(m_max, t_value);
+  }
+
+  void merge(const Histogram &t_other) {
+    for (uint32_t i = 0; i < bucket_count; ++i)
+      m_counts[i] += t_other.m_counts[i];
+    m_total += t_other.m_total;
+    m_sum += t_other.m_sum;
+    m_min = std::min(m_min, t_other.m_min);
+    m_max = std::max(m_max, t_other.m_max);
+  }
+
+  void clear() { *this = Histogram(); }
+
+  /** The smallest recorded value that at least `t_quantile` of the samples do not exceed. */
+  uint64_t percentile(const double t_quantile) const {
+    if (m_total == 0)
+      return 0;
+
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)(std::clamp(t_quantile, 0.0, 1.0) * m_total + 0.5));
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < bucket_count; ++i) {
+      seen += m_counts[i];
+      if (seen >= rank)
+        return std::min(value_of(i), m_max);
+    }
+    return m_max;
+  }
+
+  uint64_t count() const { return m_total; }
+  uint64_t sum() const { return m_sum; }
+  uint64_t min() const { return m_total ? m_min : 0; }
+  uint64_t max() const { return m_max; }
+  double mean() const { return m_total ? (double)m_sum / m_total : 0; }
+
+  /** The raw count of bucket `t_index`, for exporters. */
+  uint64_t bucket(const uint32_t t_index) const { return m_counts[t_index]; }
+
+private:
+  array<uint64_t, bucket_count> m_counts{};
+  uint64_t m_total = 0;
+  uint64_t m_sum = 0;
+  uint64_t m_min = std::numeric_limits<uint64_t>::max();
+  uint64_t m_max = 0;
+};
+
+}; // namespace gossip
+
+#endif
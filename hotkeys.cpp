@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <string>
+
+#include "hotkeys.hpp"
+
+using std::min_element;
+using std::string;
+
+namespace gossip {
+
+HotKeys::HotKeys(const size_t t_capacity) : m_capacity(t_capacity) {}
+
+void HotKeys::touch(const string &t_key) {
+  auto it = m_counters.find(t_key);
+  if (it != m_counters.end()) {
+    ++it->second.count;
+    return;
+  }
+
+  if (m_counters.size() < m_capacity) {
+    m_counters.emplace(t_key, Counter{1, 0});
+    return;
+  }
+
+  auto victim = min_element(m_counters.begin(), m_counters.end(), [](const auto &lhs, const auto &rhs) {
+    return lhs.second.count < rhs.second.count;
+  });
+  uint64_t floor = victim->second.count;
+  m_counters.erase(victim);
+  m_counters.emplace(t_key, Counter{floor + 1, floor});
+}
+
+vector<string> HotKeys::rotate(const uint64_t t_threshold, const steady_clock::time_point t_now) {
+  vector<string> hot;
+  for (auto it = m_counters.begin(); it != m_counters.end();) {
+    Counter &counter = it->second;
+    if (counter.count - counter.error >= t_threshold)
+      hot.push_back(it->first);
+
+    counter.count /= 2;
+    counter.error /= 2;
+    if (counter.count == 0)
+      it = m_counters.erase(it);
+    else
+      ++it;
+  }
+
+  std::erase_if(m_announced, [t_now](const auto &announced) { return announced.second < t_now; });
+  return hot;
+}
+
+void HotKeys::announce(const string &t_key, const steady_clock::time_point t_expiry) { m_announced[t_key] = t_expiry; }
+
+bool HotKeys::announced(const string &t_key, const steady_clock::time_point t_now) {
+  auto it = m_announced.find(t_key);
+  if (it == m_announced.end())
+    return false;
+
+  if (it->second < t_now) {
+    m_announced.erase(it);
+    return false;
+  }
+
+  return true;
+}
+
+void HotKeys::forget(const string &t_key) { m_announced.erase(t_key); }
+
+NearCache::NearCache(const size_t t_capacity) : m_capacity(t_capacity) {}
+
+optional<Cache::Entry> NearCache::get(const string &t_key, const steady_clock::time_point t_now) {
+  auto it = m_items.find(t_key);
+  if (it == m_items.end())
+    return {};
+
+  if (it->second.expiry < t_now) {
+    m_items.erase(it);
+    ++m_evictions;
+    return {};
+  }
+
+  return it->second.entry;
+}
+
+void NearCache::put(const string &t_key,
+                    const Cache::Entry &t_entry,
+                    const steady_clock::time_point t_expiry,
+                    const steady_clock::time_point t_now) {
+  if (m_items.size() >= m_capacity && !m_items.contains(t_key)) {
+    m_evictions += std::erase_if(m_items, [t_now](const auto &item) { return item.second.expiry < t_now; });
+    if (m_items.size() >= m_capacity) {
+      m_items.erase(m_items.begin());
+      ++m_evictions;
+    }
+  }
+
+  m_items[t_key] = Item{t_entry, t_expiry};
+}
+
+void NearCache::erase(const string &t_key) { m_items.erase(t_key); }
+
+size_t NearCache::size() const { return m_items.size(); }
+
+uint64_t NearCache::evictions() const { return m_evictions; }
+
+}; // namespace gossip
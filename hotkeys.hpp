@@ -0,0 +1,78 @@
+#ifndef HOTKEYS_HPP
+#define HOTKEYS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cache.hpp"
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+using std::chrono::steady_clock;
+
+namespace gossip {
+
+/**
+ * Space-Saving heavy-hitter counter over a fixed number of slots. Counts are
+ * halved at every `rotate`, so they approximate a sliding window of recent
+ * accesses rather than all-time totals.
+ */
+class HotKeys {
+  struct Counter {
+    uint64_t count = 0;
+    uint64_t error = 0;
+  };
+
+  size_t m_capacity;
+  unordered_map<string, Counter> m_counters;
+  unordered_map<string, steady_clock::time_point> m_announced;
+
+public:
+  HotKeys(const size_t t_capacity = 64);
+
+  void touch(const string &t_key);
+
+  /** Returns the keys whose guaranteed count reached `t_threshold`, then decays every counter and drops announcements lapsed by `t_now`. */
+  vector<string> rotate(const uint64_t t_threshold, const steady_clock::time_point t_now);
+
+  /** Remembers that a key was replicated to every member until `t_expiry`. */
+  void announce(const string &t_key, const steady_clock::time_point t_expiry);
+
+  /** Whether a key currently has near-cache copies that a write must invalidate. */
+  bool announced(const string &t_key, const steady_clock::time_point t_now);
+  void forget(const string &t_key);
+};
+
+/** A bounded, TTL-based local copy of keys owned by other members. Expiry is judged against the `t_now` passed in. */
+class NearCache {
+  struct Item {
+    Cache::Entry entry;
+    steady_clock::time_point expiry;
+  };
+
+  size_t m_capacity;
+  unordered_map<string, Item> m_items;
+  uint64_t m_evictions = 0;
+
+public:
+  NearCache(const size_t t_capacity = 4096);
+
+  optional<Cache::Entry> get(const string &t_key, const steady_clock::time_point t_now);
+  void put(const string &t_key,
+           const Cache::Entry &t_entry,
+           const steady_clock::time_point t_expiry,
+           const steady_clock::time_point t_now);
+  void erase(const string &t_key);
+  size_t size() const;
+
+  /** How many items expired or were pushed out by capacity so far; explicit erases do not count. */
+  uint64_t evictions() const;
+};
+
+}; // namespace gossip
+
+#endif
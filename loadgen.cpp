@@ -0,0 +1,462 @@
+#include <array>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gossip.hpp"
+#include "histogram.hpp"
+
+using boost::archive::text_iarchive;
+using boost::asio::buffer;
+using boost::asio::io_context;
+using boost::asio::steady_timer;
+using boost::asio::ip::udp;
+using boost::program_options::error;
+using boost::program_options::notify;
+using boost::program_options::options_description;
+using boost::program_options::parse_command_line;
+using boost::program_options::store;
+using boost::program_options::value;
+using boost::program_options::variables_map;
+using boost::system::error_code;
+using gossip::Codec;
+using gossip::Histogram;
+using gossip::Member;
+using gossip::message::Get;
+using gossip::message::Message;
+using gossip::message::Value;
+using std::array;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::make_shared;
+using std::map;
+using std::optional;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+  vector<Member> members;
+  uint32_t connections = 16;
+  uint32_t depth = 1;
+  double rate = 0;
+  double get_ratio = 0.9;
+  uint64_t keys = 100000;
+  double zipf = 0.99;
+  uint32_t value_size = 100;
+  int32_t duration = 10000;
+  int32_t warmup = 1000;
+  int32_t timeout = 1000;
+  uint64_t seed = 1;
+};
+
+/**
+ * Zipf-distributed ranks in [0, n) with constant-time sampling (Gray et al.,
+ * "Quickly Generating Billion-Record Synthetic Databases"). Ranks are scrambled
+ * so the hottest keys spread over partitions instead of clustering by name.
+ */
+class Zipf {
+  uint64_t m_n;
+  double m_theta;
+  double m_alpha;
+  double m_zetan;
+  double m_eta;
+  std::uniform_real_distribution<double> m_uniform{0, 1};
+
+public:
+  Zipf(const uint64_t t_n, const double t_theta) : m_n(t_n), m_theta(t_theta) {
+    double zeta2 = 0;
+    m_zetan = 0;
+    for (uint64_t i = 1; i <= m_n; ++i) {
+      m_zetan += 1 / std::pow((double)i, m_theta);
+      if (i == 2)
+        zeta2 = m_zetan;
+    }
+    m_alpha = 1 / (1 - m_theta);
+    m_eta = m_n > 2 ? (1 - std::pow(2.0 / m_n, 1 - m_theta)) / (1 - zeta2 / m_zetan) : 1;
+  }
+
+  template <typename Generator>
+  uint64_t operator()(Generator &t_random) {
+    double u = m_uniform(t_random);
+    double uz = u * m_zetan;
+    uint64_t rank;
+    if (uz < 1)
+      rank = 0;
+    else if (uz < 1 + std::pow(0.5, m_theta))
+      rank = 1;
+    else
+      rank = std::min<uint64_t>(m_n - 1, m_n * std::pow(m_eta * u - m_eta + 1, m_alpha));
+    return gossip::hash(std::to_string(rank)) % m_n;
+  }
+};
+
+/** Totals across every connection. */
+struct Report {
+  Histogram<7> latency;
+  uint64_t completed = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t errors = 0;
+  uint64_t timeouts = 0;
+  uint64_t sent = 0;
+};
+
+class Load;
+
+/**
+ * One UDP socket towards one member. Replies are matched to requests by the
+ * header sequence; at most `depth` requests are in flight and the rest wait in
+ * the backlog with their intended start time, so queueing delay is measured.
+ */
+class Connection {
+  Load &m_load;
+  udp::socket m_socket;
+  udp::endpoint m_target;
+  Member::shared_ptr m_destination;
+  udp::endpoint m_sender;
+  array<char, 65536> m_buffer;
+  uint32_t m_sequence = 0;
+  map<uint32_t, steady_clock::time_point> m_outstanding;
+  std::deque<steady_clock::time_point> m_backlog;
+
+  void m_receive();
+  void m_send(const steady_clock::time_point t_start);
+  void m_refill();
+
+public:
+  Connection(Load &t_load, io_context &t_context, const Member &t_target);
+
+  /** Issues a request intended to start at `t_start`, now or once a slot frees up. */
+  void issue(const steady_clock::time_point t_start);
+  void expire(const steady_clock::time_point t_now);
+};
+
+class Load {
+  Options m_options;
+  io_context m_context;
+  vector<unique_ptr<Connection>> m_connections;
+  steady_timer m_timer{m_context};
+  std::mt19937_64 m_random;
+  Zipf m_zipf;
+  std::bernoulli_distribution m_get;
+  string m_value;
+  Codec m_codec;
+  steady_clock::time_point m_start;
+  steady_clock::time_point m_measure_at;
+  steady_clock::time_point m_stop_at;
+  uint64_t m_issued = 0;
+  size_t m_next = 0;
+
+  void m_tick();
+
+public:
+  Report report;
+
+  Load(const Options &t_options);
+
+  void run();
+
+  /** The next request, serialized for the wire. */
+  string request(const uint32_t t_sequence, const Member::shared_ptr t_destination);
+
+  /** Records a reply, or a timeout when `t_value` is empty. */
+  void complete(const steady_clock::time_point t_start, const optional<Value> t_value);
+
+  /** Whether the run still accepts new requests. */
+  bool running() const;
+
+  const Options &options() const { return m_options; }
+  const Codec &codec() const { return m_codec; }
+};
+
+Connection::Connection(Load &t_load, io_context &t_context, const Member &t_target)
+    : m_load(t_load),
+      m_socket(t_context, udp::endpoint(t_target.address().protocol(), 0)),
+      m_target(t_target.address()),
+      m_destination(make_shared<Member>(t_target)) {
+  m_receive();
+}
+
+void Connection::issue(const steady_clock::time_point t_start) {
+  if (m_outstanding.size() < m_load.options().depth)
+    m_send(t_start);
+  else
+    m_backlog.push_back(t_start);
+}
+
+void Connection::m_send(const steady_clock::time_point t_start) {
+  uint32_t sequence = ++m_sequence;
+  auto data = make_shared<string>(m_load.request(sequence, m_destination));
+  m_outstanding[sequence] = t_start;
+  ++m_load.report.sent;
+  m_socket.async_send_to(buffer(*data), m_target, [data](const error_code ec, const size_t length) {});
+}
+
+void Connection::m_receive() {
+  m_socket.async_receive_from(buffer(m_buffer), m_sender, [this](const error_code ec, const size_t length) {
+    if (ec)
+      return;
+
+    optional<Value> reply;
+    if (auto data = m_load.codec().decode(string(m_buffer.data(), length))) {
+      try {
+        Message::shared_ptr message;
+        std::istringstream iss(*data);
+        text_iarchive ia(iss);
+        ia >> message;
+        if (auto value = std::dynamic_pointer_cast<Value>(message))
+          reply = *value;
+      } catch (const std::exception &e) {
+      }
+    }
+
+    if (reply) {
+      auto it = m_outstanding.find(reply->m_request);
+      if (it != m_outstanding.end()) {
+        m_load.complete(it->second, reply);
+        m_outstanding.erase(it);
+        m_refill();
+      }
+    }
+    m_receive();
+  });
+}
+
+void Connection::m_refill() {
+  while (m_load.running() && m_outstanding.size() < m_load.options().depth) {
+    if (!m_backlog.empty()) {
+      m_send(m_backlog.front());
+      m_backlog.pop_front();
+    } else if (m_load.options().rate <= 0) {
+      m_send(steady_clock::now());
+    } else {
+      break;
+    }
+  }
+}
+
+void Connection::expire(const steady_clock::time_point t_now) {
+  auto deadline = t_now - milliseconds(m_load.options().timeout);
+  for (auto it = m_outstanding.begin(); it != m_outstanding.end();) {
+    if (it->second > deadline) {
+      ++it;
+      continue;
+    }
+    m_load.complete(it->second, {});
+    it = m_outstanding.erase(it);
+  }
+  m_refill();
+}
+
+Load::Load(const Options &t_options)
+    : m_options(t_options),
+      m_random(t_options.seed),
+      m_zipf(t_options.keys, t_options.zipf),
+      m_get(t_options.get_ratio),
+      m_value(t_options.value_size, 'v') {
+  for (uint32_t i = 0; i < m_options.connections; ++i)
+    m_connections.push_back(std::make_unique<Connection>(*this, m_context, m_options.members[i % m_options.members.size()]));
+}
+
+string Load::request(const uint32_t t_sequence, const Member::shared_ptr t_destination) {
+  Message::Header header(t_sequence, 1, t_destination);
+  string key = "key:" + std::to_string(m_zipf(m_random));
+  Message::shared_ptr message;
+  if (m_get(m_random))
+    message = make_shared<Get>(header, key, 0);
+  else
+    message = make_shared<gossip::message::Set>(header, key, m_value, 0);
+  return gossip::message::to_string(message);
+}
+
+void Load::complete(const steady_clock::time_point t_start, const optional<Value> t_value) {
+  auto now = steady_clock::now();
+  if (t_start < m_measure_at || now >= m_stop_at)
+    return;
+
+  if (!t_value) {
+    ++report.timeouts;
+    return;
+  }
+
+  ++report.completed;
+  report.latency.record(duration_cast<nanoseconds>(now - t_start).count());
+  auto error = (gossip::Error)t_value->m_error;
+  if (t_value->m_found)
+    ++report.hits;
+  else if (error == gossip::Error::NOT_FOUND || error == gossip::Error::NONE)
+    ++report.misses;
+  else
+    ++report.errors;
+}
+
+bool Load::running() const { return steady_clock::now() < m_stop_at; }
+
+void Load::m_tick() {
+  auto now = steady_clock::now();
+  if (now >= m_stop_at) {
+    m_context.stop();
+    return;
+  }
+
+  for (auto &connection : m_connections)
+    connection->expire(now);
+
+  if (m_options.rate > 0) {
+    // Open loop: requests are due on a fixed schedule whatever the replies do,
+    // and latency counts from the scheduled time rather than the send.
+    auto interval = duration_cast<steady_clock::duration>(std::chrono::duration<double>(1 / m_options.rate));
+    for (auto due = m_start + interval * m_issued; due <= now; due = m_start + interval * ++m_issued) {
+      m_connections[m_next]->issue(due);
+      m_next = (m_next + 1) % m_connections.size();
+    }
+  }
+
+  m_timer.expires_after(milliseconds(1));
+  m_timer.async_wait([this](const error_code ec) {
+    if (!ec)
+      m_tick();
+  });
+}
+
+void Load::run() {
+  m_start = steady_clock::now();
+  m_measure_at = m_start + milliseconds(m_options.warmup);
+  m_stop_at = m_measure_at + milliseconds(m_options.duration);
+
+  // Closed loop: every connection keeps `depth` requests in flight and
+  // refills a slot as soon as it frees up.
+  if (m_options.rate <= 0) {
+    for (auto &connection : m_connections)
+      connection->expire(m_start);
+  }
+
+  m_tick();
+  m_context.run();
+}
+
+bool parse_args(int argc, char *argv[], Options &options) {
+  options_description description("Cache Cluster Load Generator");
+  description.add_options()
+      .
+      operator()("help", "Prints this message")
+      .
+      operator()("memberlist,m",
+                 value(&options.members)
+                     ->value_name("[ip] [port]")
+                     ->multitoken()
+                     ->required(),
+                 "The members requests are spread over")
+      .
+      operator()("connections,c",
+                 value(&options.connections)->default_value(options.connections),
+                 "The number of sockets, assigned to members round-robin")
+      .
+      operator()("depth,d",
+                 value(&options.depth)->default_value(options.depth),
+                 "The requests each connection keeps in flight")
+      .
+      operator()("rate",
+                 value(&options.rate)->default_value(options.rate),
+                 "Requests per second across all connections; 0 runs closed loop")
+      .
+      operator()("get-ratio",
+                 value(&options.get_ratio)->default_value(options.get_ratio),
+                 "The fraction of requests that are GETs; the rest are SETs")
+      .
+      operator()("keys",
+                 value(&options.keys)->default_value(options.keys),
+                 "The number of distinct keys")
+      .
+      operator()("zipf",
+                 value(&options.zipf)->default_value(options.zipf),
+                 "The Zipf skew of key popularity; 0 is uniform")
+      .
+      operator()("value-size",
+                 value(&options.value_size)->default_value(options.value_size),
+                 "The size of SET values in bytes")
+      .
+      operator()("duration",
+                 value(&options.duration)->default_value(options.duration),
+                 "The measured time in milliseconds")
+      .
+      operator()("warmup",
+                 value(&options.warmup)->default_value(options.warmup),
+                 "The unmeasured time in milliseconds before the run")
+      .
+      operator()("timeout",
+                 value(&options.timeout)->default_value(options.timeout),
+                 "How long in milliseconds a request may go unanswered")
+      .
+      operator()("seed",
+                 value(&options.seed)->default_value(options.seed),
+                 "The seed of the key and operation choices");
+
+  variables_map args;
+  try {
+    store(parse_command_line(argc, argv, description), args);
+    if (args.count("help")) {
+      cout << description << endl;
+      return false;
+    }
+    notify(args);
+  } catch (error e) {
+    cerr << e.what() << endl;
+    return false;
+  }
+
+  return !options.members.empty() && options.connections > 0 && options.depth > 0 && options.keys > 0 &&
+         options.zipf != 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parse_args(argc, argv, options))
+    return 1;
+
+  Load load(options);
+  load.run();
+
+  auto &report = load.report;
+  auto us = [&report](const double t_quantile) { return report.latency.percentile(t_quantile) / 1000.0; };
+  double seconds = options.duration / 1000.0;
+  cout << std::fixed << std::setprecision(1);
+  cout << "mode: " << (options.rate > 0 ? "open" : "closed") << endl;
+  cout << "sent: " << report.sent << endl;
+  cout << "completed: " << report.completed << endl;
+  cout << "throughput_rps: " << report.completed / seconds << endl;
+  cout << "hits: " << report.hits << endl;
+  cout << "misses: " << report.misses << endl;
+  cout << "errors: " << report.errors << endl;
+  cout << "timeouts: " << report.timeouts << endl;
+  cout << "latency_us_p50: " << us(0.5) << endl;
+  cout << "latency_us_p90: " << us(0.9) << endl;
+  cout << "latency_us_p99: " << us(0.99) << endl;
+  cout << "latency_us_p999: " << us(0.999) << endl;
+  cout << "latency_us_max: " << report.latency.max() / 1000.0 << endl;
+  return 0;
+}
@@ -0,0 +1,478 @@
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/asio.hpp>
+#include <boost/log/trivial.hpp>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <linux/futex.h>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "gossip.hpp"
+#include "local.hpp"
+
+using boost::archive::text_iarchive;
+using boost::asio::buffer;
+using boost::asio::ip::address_v4;
+using boost::system::error_code;
+using gossip::message::Get;
+using gossip::message::Message;
+using gossip::message::Value;
+using std::make_shared;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+namespace gossip {
+namespace {
+
+const uint32_t wrap_marker = UINT32_MAX;
+const uint32_t handshake_magic = 0x4c4f4341; // "LOCA"
+// About one serialized round trip; parking costs a futex wake on both sides.
+const microseconds spin_time(50);
+
+struct Handshake {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t id;
+  uint32_t reserved;
+  uint64_t capacity;
+};
+
+size_t frame_size(const size_t t_payload) { return (sizeof(uint32_t) + t_payload + 7) & ~(size_t)7; }
+
+long futex(atomic<uint32_t> &t_word, const int t_op, const uint32_t t_value, const timespec *t_timeout) {
+  // Not FUTEX_PRIVATE: the word lives in memory mapped by two processes.
+  return syscall(SYS_futex, reinterpret_cast<uint32_t *>(&t_word), t_op, t_value, t_timeout, nullptr, 0);
+}
+
+} // namespace
+
+size_t ShmRing::size_of(const size_t t_capacity) { return sizeof(Header) + t_capacity; }
+
+ShmRing::ShmRing(void *t_region, const size_t t_capacity, const bool t_create)
+    : m_header(static_cast<Header *>(t_region)),
+      m_data(static_cast<char *>(t_region) + sizeof(Header)),
+      m_capacity(t_capacity) {
+  if (t_create)
+    new (t_region) Header{};
+}
+
+bool ShmRing::push(const string_view t_frame) {
+  size_t need = frame_size(t_frame.size());
+  if (need > m_capacity / 2)
+    return false;
+
+  uint64_t head = m_header->head.load(std::memory_order_relaxed);
+  uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+  size_t offset = head % m_capacity;
+  size_t skip = m_capacity - offset < need ? m_capacity - offset : 0;
+  if (m_capacity - (head - tail) < skip + need)
+    return false;
+
+  // Frames never straddle the end, so the rest of the ring is skipped with a marker.
+  if (skip) {
+    std::memcpy(m_data + offset, &wrap_marker, sizeof(wrap_marker));
+    head += skip;
+    offset = 0;
+  }
+
+  uint32_t length = t_frame.size();
+  std::memcpy(m_data + offset, &length, sizeof(length));
+  std::memcpy(m_data + offset + sizeof(length), t_frame.data(), t_frame.size());
+  m_header->head.store(head + need, std::memory_order_release);
+  return true;
+}
+
+size_t ShmRing::poll(const ConsumeFn &t_consume, const size_t t_max) {
+  if (m_corrupt)
+    return 0;
+
+  // The other process can write anything to the shared memory, so every index and length is checked before use.
+  uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+  uint64_t head = m_header->head.load(std::memory_order_acquire);
+  if (head - tail > m_capacity || tail % 8) {
+    m_corrupt = true;
+    return 0;
+  }
+
+  size_t count = 0;
+  while (tail != head && count < t_max) {
+    size_t offset = tail % m_capacity;
+    size_t room = m_capacity - offset;
+    uint32_t length;
+    std::memcpy(&length, m_data + offset, sizeof(length));
+    if (length == wrap_marker) {
+      if (room > head - tail) {
+        m_corrupt = true;
+        break;
+      }
+      tail += room;
+      continue;
+    }
+    if (length > room - sizeof(length) || frame_size(length) > head - tail) {
+      m_corrupt = true;
+      break;
+    }
+
+    t_consume(string_view(m_data + offset + sizeof(length), length));
+    tail += frame_size(length);
+    m_header->tail.store(tail, std::memory_order_release);
+    ++count;
+  }
+
+  m_header->tail.store(tail, std::memory_order_release);
+  return count;
+}
+
+bool ShmRing::corrupt() const { return m_corrupt; }
+
+bool ShmRing::empty() const {
+  return m_header->head.load(std::memory_order_acquire) == m_header->tail.load(std::memory_order_relaxed);
+}
+
+bool ShmRing::park() {
+  // Pairs with the fence in `parked`: either the producer sees the flag or this sees the frame.
+  m_header->waiting.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!empty()) {
+    unpark();
+    return false;
+  }
+  return true;
+}
+
+void ShmRing::unpark() { m_header->waiting.store(0, std::memory_order_relaxed); }
+
+bool ShmRing::parked() {
+  // A plain load first keeps the common case, a running consumer, free of a locked instruction.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return m_header->waiting.load(std::memory_order_relaxed) && m_header->waiting.exchange(0);
+}
+
+void ShmRing::wait(const microseconds t_timeout) {
+  timespec timeout{(time_t)(t_timeout.count() / 1000000), (long)(t_timeout.count() % 1000000) * 1000};
+  futex(m_header->waiting, FUTEX_WAIT, 1, &timeout);
+  unpark();
+}
+
+void ShmRing::wake() { futex(m_header->waiting, FUTEX_WAKE, 1, nullptr); }
+
+udp::endpoint LocalTransport::endpoint_of(const uint16_t t_id) { return udp::endpoint(address_v4(0x7ffffffe), t_id); }
+
+LocalTransport::LocalTransport(io_context &t_context,
+                               const shared_ptr<Transport> t_inner,
+                               const string t_path,
+                               const size_t t_capacity)
+    : m_inner(t_inner),
+      m_acceptor(t_context),
+      m_path(t_path),
+      m_capacity(t_capacity & ~(size_t)63) {
+  ::unlink(m_path.c_str());
+  m_acceptor = stream_protocol::acceptor(t_context, stream_protocol::endpoint(m_path));
+}
+
+LocalTransport::~LocalTransport() {
+  for (const auto &[id, client] : m_clients)
+    ::munmap(client->region, client->size);
+  ::unlink(m_path.c_str());
+}
+
+void LocalTransport::receive(const ReceiveFn t_receive) {
+  m_receive = t_receive;
+  m_inner->receive(t_receive);
+  if (!m_accepting) {
+    m_accepting = true;
+    m_accept();
+  }
+
+  // Batched polling: whatever clients queued since the last round is handled now.
+  vector<shared_ptr<Client>> corrupt;
+  for (const auto &[id, client] : m_clients)
+    if (!m_drain(*client))
+      corrupt.push_back(client);
+  for (const auto &client : corrupt)
+    m_close(client);
+}
+
+void LocalTransport::send(const udp::endpoint &t_destination, const shared_ptr<string> t_data) {
+  if (!local(t_destination)) {
+    m_inner->send(t_destination, t_data);
+    return;
+  }
+
+  auto it = m_clients.find(t_destination.port());
+  if (it == m_clients.end())
+    return;
+
+  auto &client = *it->second;
+  if (!client.responses.push(*t_data)) {
+    BOOST_LOG_TRIVIAL(warning) << "LocalTransport::send:"
+                               << "\t[client]:" << client.id
+                               << "\t response ring full";
+    return;
+  }
+  if (client.responses.parked())
+    client.responses.wake();
+}
+
+bool LocalTransport::local(const udp::endpoint &t_destination) const {
+  return t_destination.address() == endpoint_of(0).address();
+}
+
+void LocalTransport::m_accept() {
+  auto self = shared_from_this();
+  m_acceptor.async_accept([self](const error_code ec, stream_protocol::socket t_socket) {
+    if (ec) {
+      BOOST_LOG_TRIVIAL(error) << "LocalTransport::m_accept:"
+                               << "\t[error]:" << ec.message();
+      return;
+    }
+
+    // Ids are reused once their client is gone; 0 is never handed out.
+    uint16_t id = 0;
+    for (size_t i = 0; i < UINT16_MAX && (!id || self->m_clients.contains(id)); ++i)
+      id = ++self->m_next_id;
+
+    size_t size = 2 * ShmRing::size_of(self->m_capacity);
+    int fd = ::memfd_create("cache-cluster-local", MFD_CLOEXEC);
+    void *region = MAP_FAILED;
+    if (fd >= 0 && ::ftruncate(fd, size) == 0)
+      region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (!id || self->m_clients.contains(id) || region == MAP_FAILED) {
+      BOOST_LOG_TRIVIAL(error) << "LocalTransport::m_accept:"
+                               << "\t[error]:" << (region == MAP_FAILED ? std::strerror(errno) : "no free client id");
+      if (region != MAP_FAILED)
+        ::munmap(region, size);
+      if (fd >= 0)
+        ::close(fd);
+      self->m_accept();
+      return;
+    }
+
+    auto client = make_shared<Client>(Client{id, std::move(t_socket), region, size,
+                                             ShmRing(region, self->m_capacity, true),
+                                             ShmRing((char *)region + ShmRing::size_of(self->m_capacity), self->m_capacity, true),
+                                             {}});
+
+    // The memfd travels as SCM_RIGHTS next to the handshake; once mapped on both sides it is no longer needed.
+    Handshake handshake{handshake_magic, version, id, 0, self->m_capacity};
+    iovec data{&handshake, sizeof(handshake)};
+    char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr message{};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr *rights = CMSG_FIRSTHDR(&message);
+    rights->cmsg_level = SOL_SOCKET;
+    rights->cmsg_type = SCM_RIGHTS;
+    rights->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(rights), &fd, sizeof(int));
+    bool sent = ::sendmsg(client->socket.native_handle(), &message, MSG_NOSIGNAL) == sizeof(handshake);
+    ::close(fd);
+
+    if (sent) {
+      self->m_clients[id] = client;
+      client->requests.park();
+      self->m_ring(client);
+    } else {
+      ::munmap(region, size);
+    }
+    self->m_accept();
+  });
+}
+
+void LocalTransport::m_ring(const shared_ptr<Client> t_client) {
+  auto self = shared_from_this();
+  t_client->socket.async_read_some(buffer(t_client->doorbell), [self, t_client](const error_code ec, const size_t length) {
+    if (ec) {
+      self->m_close(t_client);
+      return;
+    }
+
+    if (!self->m_drain(*t_client)) {
+      self->m_close(t_client);
+      return;
+    }
+    self->m_ring(t_client);
+  });
+}
+
+bool LocalTransport::m_drain(Client &t_client) {
+  if (!m_receive)
+    return true;
+
+  auto sender = endpoint_of(t_client.id);
+  do {
+    t_client.requests.poll([this, &sender](const string_view t_frame) { m_receive(sender, string(t_frame)); });
+    if (t_client.requests.corrupt()) {
+      BOOST_LOG_TRIVIAL(error) << "LocalTransport::m_drain:"
+                               << "\t[client]:" << t_client.id
+                               << "\t request ring corrupt";
+      return false;
+    }
+  } while (!t_client.requests.park());
+  return true;
+}
+
+void LocalTransport::m_close(const shared_ptr<Client> t_client) {
+  auto it = m_clients.find(t_client->id);
+  if (it == m_clients.end() || it->second != t_client)
+    return;
+
+  m_clients.erase(it);
+  ::munmap(t_client->region, t_client->size);
+  error_code ec;
+  t_client->socket.close(ec);
+}
+
+LocalClient::LocalClient(const string &t_path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (t_path.size() >= sizeof(address.sun_path))
+    throw std::system_error(ENAMETOOLONG, std::generic_category(), "LocalClient: " + t_path);
+  t_path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+
+  m_socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (m_socket < 0 || ::connect(m_socket, (sockaddr *)&address, sizeof(address)) != 0) {
+    auto error = errno;
+    if (m_socket >= 0)
+      ::close(m_socket);
+    throw std::system_error(error, std::generic_category(), "LocalClient: connect " + t_path);
+  }
+
+  Handshake handshake{};
+  iovec data{&handshake, sizeof(handshake)};
+  char control[CMSG_SPACE(sizeof(int))] = {};
+  msghdr message{};
+  message.msg_iov = &data;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  int fd = -1;
+  if (::recvmsg(m_socket, &message, MSG_CMSG_CLOEXEC) == sizeof(handshake)) {
+    cmsghdr *rights = CMSG_FIRSTHDR(&message);
+    if (rights && rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS)
+      std::memcpy(&fd, CMSG_DATA(rights), sizeof(int));
+  }
+
+  if (fd >= 0 && handshake.magic == handshake_magic && handshake.version == LocalTransport::version) {
+    m_size = 2 * ShmRing::size_of(handshake.capacity);
+    m_region = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (fd >= 0)
+    ::close(fd);
+  if (!m_region || m_region == MAP_FAILED) {
+    ::close(m_socket);
+    throw std::system_error(EPROTO, std::generic_category(), "LocalClient: handshake with " + t_path);
+  }
+
+  m_requests = ShmRing(m_region, handshake.capacity, false);
+  m_responses = ShmRing((char *)m_region + ShmRing::size_of(handshake.capacity), handshake.capacity, false);
+}
+
+LocalClient::~LocalClient() {
+  ::munmap(m_region, m_size);
+  ::close(m_socket);
+}
+
+bool LocalClient::send(const string_view t_frame) {
+  if (!m_requests.push(t_frame))
+    return false;
+
+  // One byte is enough to wake the node's event loop; it reads whatever is queued.
+  if (m_requests.parked()) {
+    char doorbell = 0;
+    while (::send(m_socket, &doorbell, 1, MSG_NOSIGNAL) < 0 && errno == EINTR)
+      ;
+  }
+  return true;
+}
+
+size_t LocalClient::receive(const ShmRing::ConsumeFn &t_consume, const microseconds t_timeout) {
+  auto deadline = steady_clock::now() + t_timeout;
+  for (;;) {
+    // On a single core spinning only delays the node it is waiting for.
+    static const bool spinning = std::thread::hardware_concurrency() > 1;
+    auto spin = std::min(steady_clock::now() + (spinning ? spin_time : microseconds(0)), deadline);
+    do {
+      if (auto count = m_responses.poll(t_consume))
+        return count;
+    } while (steady_clock::now() < spin);
+
+    auto now = steady_clock::now();
+    if (now >= deadline)
+      return 0;
+    if (m_responses.park())
+      m_responses.wait(std::chrono::duration_cast<microseconds>(deadline - now));
+  }
+}
+
+optional<Cache::Entry> LocalClient::m_call(const string &t_request,
+                                           const uint32_t t_sequence,
+                                           Error &t_error,
+                                           const microseconds t_timeout) {
+  t_error = Error::WRITE_FAILED;
+  if (!send(t_request))
+    return {};
+
+  // Replies to requests that timed out earlier are skipped by sequence.
+  t_error = Error::READ_FAILED;
+  optional<Cache::Entry> entry;
+  auto deadline = steady_clock::now() + t_timeout;
+  for (bool done = false; !done;) {
+    auto now = steady_clock::now();
+    if (now >= deadline)
+      return {};
+
+    receive([&](const string_view t_frame) {
+      auto data = m_codec.decode(string(t_frame));
+      if (!data || done)
+        return;
+
+      try {
+        Message::shared_ptr message;
+        std::istringstream iss(*data);
+        text_iarchive ia(iss);
+        ia >> message;
+        auto value = std::dynamic_pointer_cast<Value>(message);
+        if (!value || value->m_request != t_sequence)
+          return;
+
+        done = true;
+        t_error = (Error)value->m_error;
+        if (value->m_found)
+          entry = value->m_entry;
+      } catch (const std::exception &e) {
+      }
+    },
+            std::chrono::duration_cast<microseconds>(deadline - now));
+  }
+  return entry;
+}
+
+optional<Cache::Entry> LocalClient::get(const string &t_key, Error &t_error, const microseconds t_timeout) {
+  uint32_t sequence = ++m_sequence;
+  Message::shared_ptr request = make_shared<Get>(Message::Header(sequence, 1, nullptr), t_key, 0);
+  return m_call(message::to_string(request), sequence, t_error, t_timeout);
+}
+
+Error LocalClient::set(const string &t_key, const string &t_value, const microseconds t_timeout) {
+  uint32_t sequence = ++m_sequence;
+  Message::shared_ptr request = make_shared<gossip::message::Set>(Message::Header(sequence, 1, nullptr), t_key, t_value, 0);
+  Error error;
+  m_call(message::to_string(request), sequence, error, t_timeout);
+  return error;
+}
+
+}; // namespace gossip
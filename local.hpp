@@ -0,0 +1,188 @@
+#ifndef LOCAL_HPP
+#define LOCAL_HPP
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "cache.hpp"
+#include "codec.hpp"
+#include "transport.hpp"
+
+using boost::asio::io_context;
+using boost::asio::ip::udp;
+using boost::asio::local::stream_protocol;
+using std::atomic;
+using std::map;
+using std::optional;
+using std::shared_ptr;
+using std::string;
+using std::string_view;
+
+namespace gossip {
+
+enum class Error;
+
+/**
+ * A single-producer single-consumer queue of byte frames over memory shared
+ * between two processes. Frames are length-prefixed, 8-byte aligned and never
+ * wrap, so the consumer reads each one in place. The consumer may park on the
+ * `waiting` word; a producer that finds it set must wake the consumer.
+ */
+class ShmRing {
+public:
+  struct Header {
+    alignas(64) atomic<uint64_t> head;
+    alignas(64) atomic<uint64_t> tail;
+    alignas(64) atomic<uint32_t> waiting;
+  };
+
+  typedef std::function<void(const string_view)> ConsumeFn;
+
+private:
+  Header *m_header = nullptr;
+  char *m_data = nullptr;
+  size_t m_capacity = 0;
+  bool m_corrupt = false;
+
+public:
+  /** The bytes a ring of `t_capacity` occupies, header included. */
+  static size_t size_of(const size_t t_capacity);
+
+  ShmRing() = default;
+
+  /** A view over a ring at `t_region`; `t_create` initializes it, otherwise it is attached as is. */
+  ShmRing(void *t_region, const size_t t_capacity, const bool t_create);
+
+  /** Copies one frame in; false when the ring is full or the frame exceeds half its capacity. */
+  bool push(const string_view t_frame);
+
+  /**
+   * Hands up to `t_max` frames to `t_consume` in place, releasing each once it
+   * returns. Indices or a length out of bounds mark the ring corrupt and end
+   * the poll, and a corrupt ring is never read again.
+   */
+  size_t poll(const ConsumeFn &t_consume, const size_t t_max = SIZE_MAX);
+
+  bool corrupt() const;
+
+  bool empty() const;
+
+  /** Consumer: announces it is about to sleep; false if a frame arrived meanwhile and it must not. */
+  bool park();
+  void unpark();
+
+  /** Producer: after a push, whether the consumer was parked and needs a wake-up; clears the flag. */
+  bool parked();
+
+  /** Consumer: sleeps on the `waiting` word until woken or `t_timeout` passes. */
+  void wait(const std::chrono::microseconds t_timeout);
+
+  /** Producer: wakes a consumer sleeping in `wait`. */
+  void wake();
+};
+
+/**
+ * Serves co-located clients over shared memory next to another transport.
+ * A client connects to a Unix socket and is handed a memfd holding two rings,
+ * requests and responses. Its datagrams appear to the node as coming from
+ * `endpoint_of(id)`, and anything sent there goes into its response ring.
+ *
+ * The node drains request rings in batches whenever it receives, and a client
+ * only rings the socket when the node has parked, so a busy node never takes
+ * a syscall per request. Responses wake a parked client with a futex.
+ */
+class LocalTransport : public Transport, public std::enable_shared_from_this<LocalTransport> {
+  struct Client {
+    uint16_t id;
+    stream_protocol::socket socket;
+    void *region;
+    size_t size;
+    ShmRing requests;
+    ShmRing responses;
+    std::array<char, 64> doorbell;
+  };
+
+  shared_ptr<Transport> m_inner;
+  stream_protocol::acceptor m_acceptor;
+  string m_path;
+  size_t m_capacity;
+  map<uint16_t, shared_ptr<Client>> m_clients;
+  uint16_t m_next_id = 0;
+  ReceiveFn m_receive;
+  bool m_accepting = false;
+
+  void m_accept();
+  void m_ring(const shared_ptr<Client> t_client);
+  bool m_drain(Client &t_client);
+  void m_close(const shared_ptr<Client> t_client);
+
+public:
+  /** The protocol version a client must present in the handshake. */
+  static const uint32_t version = 1;
+
+  /** The address every local client is reported under; the port is its id. */
+  static udp::endpoint endpoint_of(const uint16_t t_id);
+
+  LocalTransport(io_context &t_context,
+                 const shared_ptr<Transport> t_inner,
+                 const string t_path,
+                 const size_t t_capacity = 4 << 20);
+  ~LocalTransport();
+
+  virtual void receive(const ReceiveFn t_receive) override;
+  virtual void send(const udp::endpoint &t_destination, const shared_ptr<string> t_data) override;
+  virtual bool local(const udp::endpoint &t_destination) const override;
+};
+
+/**
+ * The application side of `LocalTransport`. Not thread-safe; one per thread.
+ * `send` and `receive` move serialized messages; `get` and `set` are blocking
+ * round trips built on them.
+ */
+class LocalClient {
+  int m_socket = -1;
+  void *m_region = nullptr;
+  size_t m_size = 0;
+  ShmRing m_requests;
+  ShmRing m_responses;
+  uint32_t m_sequence = 0;
+  Codec m_codec;
+
+  optional<Cache::Entry> m_call(const string &t_request, const uint32_t t_sequence, Error &t_error,
+                                const std::chrono::microseconds t_timeout);
+
+public:
+  /** Connects to the node listening at `t_path`; throws std::system_error on failure. */
+  LocalClient(const string &t_path);
+  ~LocalClient();
+
+  LocalClient(const LocalClient &) = delete;
+  LocalClient &operator=(const LocalClient &) = delete;
+
+  /** Queues one serialized message; false when the request ring is full. */
+  bool send(const string_view t_frame);
+
+  /**
+   * Hands every queued response to `t_consume` in place, without copying out of
+   * the shared region. Spins briefly and then sleeps up to `t_timeout` when
+   * there is none. Returns how many were consumed.
+   */
+  size_t receive(const ShmRing::ConsumeFn &t_consume, const std::chrono::microseconds t_timeout);
+
+  optional<Cache::Entry> get(const string &t_key, Error &t_error,
+                             const std::chrono::microseconds t_timeout = std::chrono::seconds(1));
+  Error set(const string &t_key, const string &t_value,
+            const std::chrono::microseconds t_timeout = std::chrono::seconds(1));
+};
+
+}; // namespace gossip
+
+#endif
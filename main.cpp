@@ -7,8 +7,14 @@
 #include <vector>
 
 #include "gossip.hpp"
+#ifdef __linux__
+#include "local.hpp"
+#endif
 
+using boost::asio::ip::address_v4;
+using boost::asio::ip::tcp;
 using boost::asio::ip::udp;
+using boost::program_options::bool_switch;
 using boost::program_options::error;
 using boost::program_options::notify;
 using boost::program_options::options_description;
@@ -16,13 +22,19 @@ using boost::program_options::parse_command_line;
 using boost::program_options::store;
 using boost::program_options::value;
 using boost::program_options::variables_map;
+using gossip::Exporter;
 using gossip::Gossip;
+#ifdef __linux__
+using gossip::LocalTransport;
+#endif
 using gossip::Member;
+using gossip::Trace;
 using std::cerr;
 using std::cin;
 using std::cout;
 using std::endl;
 using std::launch;
+using std::make_shared;
 using std::make_unique;
 using std::string;
 using std::unique_ptr;
@@ -31,7 +43,12 @@ using std::vector;
 unique_ptr<error> parse_args(
     int argc, char *argv[],
     Member &self_member,
-    vector<Member> &memberlist) {
+    vector<Member> &memberlist,
+    uint16_t &metrics_port,
+    string &trace_path,
+    bool &invalidate_reads,
+    string &local_path) {
+  string zone, rack;
   options_description options("Cache Cluster CLI");
   options.add_options()
       .
@@ -42,16 +59,48 @@ unique_ptr<error> parse_args(
                      ->value_name("[ip] [port]"),
                  "The endpoint of self")
       .
+      operator()("zone,z",
+                 value(&zone)
+                     ->value_name("[zone]"),
+                 "The availability zone of self")
+      .
+      operator()("rack,r",
+                 value(&rack)
+                     ->value_name("[rack]"),
+                 "The rack of self within its zone")
+      .
       operator()("memberlist,m",
                  value(&memberlist)
                      ->value_name("[ip] [port]")
                      ->multitoken(),
-                 "The endpoints of memberlist");
+                 "The endpoints of memberlist")
+      .
+      operator()("metrics,p",
+                 value(&metrics_port)
+                     ->value_name("[port]"),
+                 "The local port serving Prometheus metrics; off when omitted")
+      .
+      operator()("trace,t",
+                 value(&trace_path)
+                     ->value_name("[path]")
+                     ->default_value(trace_path),
+                 "Where the flight recorder is dumped on a crash or the TRACE command")
+      .
+      operator()("invalidate-reads",
+                 bool_switch(&invalidate_reads),
+                 "Invalidate keys served to other members on write, for client near caches")
+      .
+      operator()("local,l",
+                 value(&local_path)
+                     ->value_name("[path]"),
+                 "The Unix socket co-located clients connect to for shared-memory rings; off when omitted");
 
   variables_map args;
   try {
     store(parse_command_line(argc, argv, options), args);
     notify(args);
+    self_member.zone() = zone;
+    self_member.rack() = rack;
   } catch (error e) {
     cerr << e.what() << endl;
     return make_unique<error>(e);
@@ -63,8 +112,15 @@ unique_ptr<error> parse_args(
 int main(int argc, char *argv[]) {
   Member self_member("0.0.0.0 7777");
   vector<Member> memberlist;
+  uint16_t metrics_port = 0;
+  string trace_path = "cache-cluster.trace";
+  bool invalidate_reads = false;
+  string local_path;
 
-  parse_args(argc, argv, self_member, memberlist);
+  if (parse_args(argc, argv, self_member, memberlist, metrics_port, trace_path, invalidate_reads, local_path))
+    return 1;
+
+  Trace::dump_on_crash(trace_path);
 
   if (memberlist.empty()) {
     memberlist.insert(memberlist.end(), {"0.0.0.0 7777"});
@@ -76,15 +132,32 @@ int main(int argc, char *argv[]) {
     };
 
     auto server = Gossip(self_member, receiver);
+    server.invalidate_reads() = invalidate_reads;
+#ifdef __linux__
+    if (!local_path.empty())
+      server.transport() = make_shared<LocalTransport>(server.context(), server.transport(), local_path);
+#else
+    if (!local_path.empty())
+      cerr << "main: --local needs Linux" << endl;
+#endif
     for (auto member : memberlist) {
       server.add_member(member);
     }
 
     future<void> res = async(launch::async, &Gossip::run, &server);
 
+    unique_ptr<Exporter> exporter;
+    if (metrics_port)
+      exporter = make_unique<Exporter>(server.metrics(), tcp::endpoint(address_v4::loopback(), metrics_port));
+
     string command;
     while (cin >> command) {
-      cout << command;
+      if (command == "STATS")
+        cout << server.metrics().text();
+      else if (command == "TRACE")
+        cout << (Trace::dump(trace_path.c_str()) ? trace_path : "trace dump failed") << endl;
+      else
+        cout << command;
     }
 
     res.get();
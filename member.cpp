@@ -21,12 +21,14 @@ using std::string;
 namespace gossip {
 
 Member::Member(const udp::endpoint t_addr) : m_addr(t_addr) {}
+Member::Member(const uuid t_uid, const udp::endpoint t_addr) : m_uid(t_uid), m_addr(t_addr) {}
 Member::Member(const string t_addr) { istringstream(t_addr) >> *this; }
 
 istream &operator>>(istream &in, Member &t_member) {
   string ip;
   port_type port;
-  in >> ip >> port;
+  // Program options parse with noskipws, so skip the separator explicitly.
+  in >> std::ws >> ip >> std::ws >> port;
 
   t_member.m_addr = udp::endpoint(address::from_string(ip), port);
   return in;
@@ -35,6 +37,18 @@ istream &operator>>(istream &in, Member &t_member) {
 const uuid &Member::uid() const { return m_uid; };
 const udp::endpoint &Member::address() const { return m_addr; };
 
+string &Member::zone() { return m_zone; };
+const string &Member::zone() const { return m_zone; };
+
+string &Member::rack() { return m_rack; };
+const string &Member::rack() const { return m_rack; };
+
+uint32_t &Member::incarnation() { return m_incarnation; };
+const uint32_t &Member::incarnation() const { return m_incarnation; };
+
+bool &Member::owner() { return m_owner; };
+const bool &Member::owner() const { return m_owner; };
+
 }; // namespace gossip
 
 BOOST_CLASS_EXPORT(gossip::Member)
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <boost/asio.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/split_free.hpp>
+#include <boost/serialization/version.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -59,24 +60,55 @@ class Member {
   void serialize(Archive &ar, const unsigned int version) {
     ar &m_uid;
     ar &m_addr;
+    if (version >= 1) {
+      ar &m_zone;
+      ar &m_rack;
+    }
+    if (version >= 2)
+      ar &m_incarnation;
+    if (version >= 3)
+      ar &m_owner;
   }
 
   uuid m_uid{random_generator()()};
   udp::endpoint m_addr;
+  string m_zone;
+  string m_rack;
+  uint32_t m_incarnation = 0;
+  bool m_owner = true;
 
 public:
   using shared_ptr = std::shared_ptr<Member>;
 
   Member() = default;
   Member(const udp::endpoint t_addr);
+  Member(const uuid t_uid, const udp::endpoint t_addr);
   Member(const string t_addr);
 
   friend istream &operator>>(istream &in, Member &t_member);
 
   const uuid &uid() const;
   const udp::endpoint &address() const;
+
+  /** The failure domain the member runs in; members with the same zone are preferred gossip peers. */
+  string &zone();
+  const string &zone() const;
+
+  /** The rack within the zone; replicas spread across racks once every zone holds one. */
+  string &rack();
+  const string &rack() const;
+
+  /** Raised only by the member itself to refute a report of its failure; reports about a lower one are void. */
+  uint32_t &incarnation();
+  const uint32_t &incarnation() const;
+
+  /** Whether the member takes partitions; one that does not joins only to route requests to those that do. */
+  bool &owner();
+  const bool &owner() const;
 };
 
 }; // namespace gossip
 
+BOOST_CLASS_VERSION(gossip::Member, 3);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include <string>
+
+#include "cache.hpp"
+#include "merkle.hpp"
+
+using std::string;
+
+namespace gossip {
+namespace {
+
+uint64_t mix(uint64_t t_value) {
+  t_value ^= t_value >> 33;
+  t_value *= 0xff51afd7ed558ccdULL;
+  t_value ^= t_value >> 33;
+  t_value *= 0xc4ceb9fe1a85ec53ULL;
+  t_value ^= t_value >> 33;
+  return t_value;
+}
+
+uint64_t item(const string &t_key, const uint64_t t_stamp) {
+  if (t_stamp == 0)
+    return 0;
+  return mix(hash(t_key) ^ mix(t_stamp));
+}
+} // namespace
+
+uint32_t Merkle::leaf_of(const string &t_key) { return (hash(t_key) >> 32) % leaf_count; }
+uint32_t Merkle::leaf_index(const uint32_t t_leaf) { return leaf_count - 1 + t_leaf; }
+bool Merkle::is_leaf(const uint32_t t_node) { return t_node >= leaf_count - 1; }
+
+void Merkle::update(const string &t_key, const uint64_t t_before, const uint64_t t_after) {
+  uint32_t node = leaf_index(leaf_of(t_key));
+  m_nodes[node] ^= item(t_key, t_before) ^ item(t_key, t_after);
+
+  while (node != 0) {
+    node = (node - 1) / 2;
+    uint64_t left = m_nodes[2 * node + 1], right = m_nodes[2 * node + 2];
+    m_nodes[node] = (left | right) ? mix(left ^ mix(right + node)) : 0;
+  }
+}
+
+void Merkle::clear() { m_nodes.fill(0); }
+
+uint64_t Merkle::root() const { return m_nodes[0]; }
+uint64_t Merkle::node(const uint32_t t_node) const { return m_nodes[t_node]; }
+
+}; // namespace gossip
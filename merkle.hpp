@@ -0,0 +1,42 @@
+#ifndef MERKLE_HPP
+#define MERKLE_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+using std::array;
+using std::string;
+
+namespace gossip {
+
+/**
+ * A fixed-shape hash tree over the key -> (version, writer) pairs of one partition.
+ * Keys are bucketed into leaves by hash; a leaf is the XOR of its item hashes so
+ * a write updates it in O(1), and only the `depth` ancestors are rehashed.
+ * Nodes are stored heap-ordered: node 0 is the root, children of i are 2i+1 and 2i+2.
+ */
+class Merkle {
+public:
+  static const uint32_t depth = 6;
+  static const uint32_t leaf_count = 1 << depth;
+  static const uint32_t node_count = 2 * leaf_count - 1;
+
+  static uint32_t leaf_of(const string &t_key);
+  static uint32_t leaf_index(const uint32_t t_leaf);
+  static bool is_leaf(const uint32_t t_node);
+
+  /** Replaces `t_key` at stamp `t_before` with `t_key` at `t_after`; stamp 0 means absent. */
+  void update(const string &t_key, const uint64_t t_before, const uint64_t t_after);
+  void clear();
+
+  uint64_t root() const;
+  uint64_t node(const uint32_t t_node) const;
+
+private:
+  array<uint64_t, node_count> m_nodes{};
+};
+
+}; // namespace gossip
+
+#endif
@@ -7,6 +7,7 @@
 #include <boost/serialization/shared_ptr.hpp>
 #include <map>
 #include <memory>
+#include <set>
 #include <stdexcept>
 
 #include "gossip.hpp"
@@ -18,7 +19,10 @@ using gossip::Error;
 using gossip::Gossip;
 using gossip::Member;
 using std::logic_error;
+using std::map;
 using std::make_shared;
+using std::optional;
+using std::set;
 
 namespace gossip::message {
 
@@ -33,6 +37,10 @@ Message::Header::Header(
 Message::Message(const Header t_header) : m_header(t_header) {}
 Error Message::receive(Gossip &self, const Member t_sender) const { throw logic_error("Not implemented"); }
 
+awaitable<Error> Message::handle(Gossip &self, const Member t_sender) const { co_return receive(self, t_sender); }
+
+bool Message::suspends() const { return false; }
+
 template <IMessages_Ptr IMessage_Ptr>
 const string to_string(IMessage_Ptr t_message) {
   string serial_str;
@@ -55,15 +63,18 @@ Hello::Hello(const Header t_header,
              const Member::shared_ptr t_self_member) : m_self_member(t_self_member) { m_header = t_header; };
 
 Error Hello::receive(Gossip &self, const Member t_sender) const {
-  auto self_member = self.self_member();
-  auto sender_member = make_shared<Member>(t_sender);
-  self.enqueue_message(Welcome{self_member}, Spreading::DIRECT, sender_member);
-
-  // self.m_memberlist.emplate(t_sender);
-
-  // Message::shared_ptr memberlist = std::make_shared<Memberlist>(m_memberlist);
-  // self.enqueue_message(memberlist, t_sender, Spreading::BROADCAST);
-
+  self.advertise(t_sender, m_codecs, m_dictionaries);
+  if (!m_self_member) {
+    Welcome welcome{self.self_member()};
+    welcome.m_dictionaries = self.codec().dictionaries();
+    self.enqueue_message(welcome, Spreading::DIRECT, make_shared<Member>(t_sender));
+    return Error::NONE;
+  }
+
+  // The joiner is answered at the address it wrote from, with the memberlist as it stands without it.
+  self.advertise(*m_self_member, m_codecs, m_dictionaries);
+  self.welcome(make_shared<Member>(m_self_member->uid(), t_sender.address()));
+  self.insert_member(m_self_member);
   return Error::NONE;
 }
 }; // namespace gossip::message
@@ -77,22 +88,430 @@ Welcome::Welcome(const Member::shared_ptr t_self_member) : m_self_member(t_self_
 Welcome::Welcome(const Header t_header,
                  const Member::shared_ptr t_self_member) : m_self_member(t_self_member) { m_header = t_header; };
 
+Welcome::Welcome(const Member::shared_ptr t_self_member,
+                 const vector<Member> t_members,
+                 const Crdts::Batch t_crdts)
+    : m_self_member(t_self_member), m_complete(true), m_members(t_members), m_crdts(t_crdts){};
+
 Error Welcome::receive(Gossip &self, const Member t_sender) const {
-  auto self_member = self.self_member();
+  self.advertise(t_sender, m_codecs, m_dictionaries);
+  if (m_self_member)
+    self.advertise(*m_self_member, m_codecs, m_dictionaries);
+
+  if (!m_complete) {
+    if (m_self_member)
+      self.insert_member(m_self_member);
+    return Error::NONE;
+  }
+
+  auto members = m_members;
+  if (m_self_member)
+    members.push_back(*m_self_member);
+  return self.join(members, m_crdts);
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Welcome);
+
+namespace gossip::message {
+
+Get::Get(const Header t_header,
+         const string t_key,
+         const uint32_t t_hops) : m_key(t_key), m_hops(t_hops) { m_header = t_header; };
+
+awaitable<Error> Get::handle(Gossip &self, const Member t_sender) const {
+  auto [error, entry] = co_await self.async_get(m_key, m_hops + 1);
+  co_return co_await self.async_enqueue_message(Value{m_header.sequence, error, entry}, Spreading::DIRECT, make_shared<Member>(t_sender));
+}
+
+bool Get::suspends() const { return true; }
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Get);
+
+namespace gossip::message {
+
+Set::Set(const Header t_header,
+         const string t_key,
+         const string t_value,
+         const uint32_t t_hops) : m_key(t_key), m_value(t_value), m_hops(t_hops) { m_header = t_header; };
+
+awaitable<Error> Set::handle(Gossip &self, const Member t_sender) const {
+  auto [error, entry] = co_await self.async_set(m_key, m_value, m_hops + 1);
+  co_return co_await self.async_enqueue_message(Value{m_header.sequence, error, entry}, Spreading::DIRECT, make_shared<Member>(t_sender));
+}
+
+bool Set::suspends() const { return true; }
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Set);
+
+namespace gossip::message {
+
+Value::Value(const uint32_t t_request,
+             const Error t_error,
+             const optional<Cache::Entry> t_entry)
+    : m_request(t_request),
+      m_error((int32_t)t_error),
+      m_found(t_entry.has_value()),
+      m_entry(t_entry.value_or(Cache::Entry{})) {}
+
+Error Value::receive(Gossip &self, const Member t_sender) const {
+  optional<Cache::Entry> entry;
+  if (m_found)
+    entry = m_entry;
+
+  return self.complete(m_request, (Error)m_error, entry);
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Value);
+
+namespace gossip::message {
+
+MultiGet::MultiGet(const Header t_header,
+                   const vector<string> t_keys,
+                   const uint32_t t_hops) : m_keys(t_keys), m_hops(t_hops) { m_header = t_header; };
+
+awaitable<Error> MultiGet::handle(Gossip &self, const Member t_sender) const {
+  auto results = co_await self.async_mget(m_keys, m_hops + 1);
+  co_return co_await self.async_enqueue_message(MultiValue{m_header.sequence, results}, Spreading::DIRECT, make_shared<Member>(t_sender));
+}
+
+bool MultiGet::suspends() const { return true; }
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::MultiGet);
+
+namespace gossip::message {
+
+MultiSet::MultiSet(const Header t_header,
+                   const vector<pair<string, string>> t_items,
+                   const uint32_t t_hops) : m_items(t_items), m_hops(t_hops) { m_header = t_header; };
+
+awaitable<Error> MultiSet::handle(Gossip &self, const Member t_sender) const {
+  auto results = co_await self.async_mset(m_items, m_hops + 1);
+  co_return co_await self.async_enqueue_message(MultiValue{m_header.sequence, results}, Spreading::DIRECT, make_shared<Member>(t_sender));
+}
+
+bool MultiSet::suspends() const { return true; }
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::MultiSet);
+
+namespace gossip::message {
+
+MultiValue::MultiValue(const uint32_t t_request,
+                       const vector<pair<Error, optional<Cache::Entry>>> t_results) : m_request(t_request) {
+  for (const auto &[error, entry] : t_results) {
+    m_errors.push_back((int32_t)error);
+    m_found.push_back(entry.has_value());
+    m_entries.push_back(entry.value_or(Cache::Entry{}));
+  }
+}
+
+Error MultiValue::receive(Gossip &self, const Member t_sender) const {
+  vector<Gossip::Result> results;
+  for (size_t i = 0; i < m_errors.size(); ++i) {
+    optional<Cache::Entry> entry;
+    if (m_found[i])
+      entry = m_entries[i];
+    results.emplace_back((Error)m_errors[i], entry);
+  }
+
+  return self.complete(m_request, results);
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::MultiValue);
+
+namespace gossip::message {
+
+Digest::Node::Node(const uint32_t t_partition,
+                   const uint32_t t_index,
+                   const uint64_t t_hash)
+    : partition(t_partition),
+      index(t_index),
+      hash(t_hash) {}
+
+Digest::Digest(const uint64_t t_membership,
+               const vector<Node> t_nodes) : m_membership(t_membership), m_nodes(t_nodes) {}
+
+Error Digest::receive(Gossip &self, const Member t_sender) const {
+  for (const auto &node : m_nodes)
+    if (node.partition >= Cache::partition_count || node.index >= Merkle::node_count)
+      return Error::INVALID_MESSAGE;
+
   auto sender_member = make_shared<Member>(t_sender);
-  Message::shared_ptr welcome = make_shared<Welcome>(self_member);
-  // self.enqueue_message(welcome, t_sender, Spreading::DIRECT);
+  if (m_membership != 0 && m_membership != self.membership_digest())
+    self.enqueue_message(Roster{self.roster(), true}, Spreading::DIRECT, sender_member);
+
+  vector<Node> children;
+  for (const auto &node : m_nodes) {
+    const Merkle &tree = self.cache().tree(node.partition);
+    if (tree.node(node.index) == node.hash)
+      continue;
+
+    if (Merkle::is_leaf(node.index)) {
+      uint32_t leaf = node.index - Merkle::leaf_index(0);
+      self.send_entries(sender_member, node.partition, leaf, self.cache().leaf(node.partition, leaf), true);
+      continue;
+    }
 
-  // self.m_memberlist.emplate(t_sender);
+    for (uint32_t child : {2 * node.index + 1, 2 * node.index + 2})
+      children.emplace_back(node.partition, child, tree.node(child));
+  }
 
-  // Message::shared_ptr memberlist = std::make_shared<Memberlist>(m_memberlist);
-  // self.enqueue_message(memberlist, t_sender, Spreading::BROADCAST);
+  if (!children.empty())
+    self.send_digest(sender_member, 0, children);
 
   return Error::NONE;
 }
 }; // namespace gossip::message
 
-BOOST_CLASS_EXPORT(gossip::message::Welcome);
+BOOST_CLASS_EXPORT(gossip::message::Digest);
+
+namespace gossip::message {
+
+Entries::Entries(const uint32_t t_partition,
+                 const uint32_t t_leaf,
+                 const Cache::Range t_entries,
+                 const bool t_reply)
+    : m_partition(t_partition),
+      m_leaf(t_leaf),
+      m_entries(t_entries),
+      m_reply(t_reply) {}
+
+Error Entries::receive(Gossip &self, const Member t_sender) const {
+  if (m_partition >= Cache::partition_count || m_leaf >= Merkle::leaf_count)
+    return Error::INVALID_MESSAGE;
+
+  Cache &cache = self.cache();
+  for (const auto &[key, entry] : m_entries)
+    cache.apply(key, entry);
+
+  if (!m_reply)
+    return Error::NONE;
+
+  map<string, Cache::Entry> received;
+  for (const auto &[key, entry] : m_entries)
+    received[key] = entry;
+
+  Cache::Range newer;
+  for (const auto &[key, entry] : cache.leaf(m_partition, m_leaf)) {
+    auto it = received.find(key);
+    if (it == received.end() || entry.supersedes(it->second))
+      newer.emplace_back(key, entry);
+  }
+
+  if (!newer.empty())
+    self.send_entries(make_shared<Member>(t_sender), m_partition, m_leaf, newer, false);
+
+  return Error::NONE;
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Entries);
+
+namespace gossip::message {
+
+Memberlist::Memberlist(const vector<Member> t_members) : m_members(t_members) {}
+
+Error Memberlist::receive(Gossip &self, const Member t_sender) const {
+  for (const auto &member : m_members)
+    self.insert_member(make_shared<Member>(member));
+
+  return Error::NONE;
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Memberlist);
+
+namespace gossip::message {
+
+Obituary::Obituary(const vector<Member> t_members) : m_members(t_members) {}
+
+Error Obituary::receive(Gossip &self, const Member t_sender) const {
+  for (const auto &member : m_members)
+    self.bury(member);
+
+  return Error::NONE;
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Obituary);
+
+namespace gossip::message {
+
+Roster::Roster(const vector<uuid> t_members, const bool t_reply) : m_members(t_members), m_reply(t_reply) {}
+
+Error Roster::receive(Gossip &self, const Member t_sender) const {
+  set<uuid> theirs(m_members.begin(), m_members.end());
+  vector<Member> missing;
+  if (!theirs.count(self.self_member()->uid()))
+    missing.push_back(*self.self_member());
+  for (const auto &member : self.memberlist())
+    if (!theirs.erase(member->uid()))
+      missing.push_back(*member);
+  theirs.erase(self.self_member()->uid());
+
+  // Members they still list that failed here are reported back rather than asked for.
+  vector<Member> dead;
+  for (auto it = theirs.begin(); it != theirs.end();) {
+    auto tombstone = self.tombstone(*it);
+    if (!tombstone) {
+      ++it;
+      continue;
+    }
+    dead.push_back(*tombstone);
+    it = theirs.erase(it);
+  }
+
+  auto sender_member = make_shared<Member>(t_sender);
+  if (!missing.empty())
+    self.enqueue_message(Memberlist{missing}, Spreading::DIRECT, sender_member);
+  if (!dead.empty())
+    self.enqueue_message(Obituary{dead}, Spreading::DIRECT, sender_member);
+  if (m_reply && !theirs.empty())
+    self.enqueue_message(Roster{self.roster(), false}, Spreading::DIRECT, sender_member);
+  return Error::NONE;
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Roster);
+
+namespace gossip::message {
+
+Hot::Hot(const string t_key,
+         const Cache::Entry t_entry,
+         const int32_t t_ttl) : m_key(t_key), m_entry(t_entry), m_ttl(t_ttl) {}
+
+Error Hot::receive(Gossip &self, const Member t_sender) const {
+  if (self.replicates(Cache::partition_of(m_key)))
+    return Error::NONE;
+
+  auto now = self.clock().now();
+  self.near_cache().put(m_key, m_entry, now + std::chrono::milliseconds(m_ttl), now);
+  if (self.invalidation_listener())
+    self.invalidation_listener()(m_key);
+  return Error::NONE;
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Hot);
+
+namespace gossip::message {
+
+Invalidate::Invalidate(const vector<string> t_keys) : m_keys(t_keys) {}
+
+Error Invalidate::receive(Gossip &self, const Member t_sender) const {
+  self.invalidate(m_keys);
+  return Error::NONE;
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Invalidate);
+
+namespace gossip::message {
+
+Delta::Delta(const Crdts::Batch t_batch) : m_batch(t_batch) {}
+
+Error Delta::receive(Gossip &self, const Member t_sender) const {
+  self.crdts().merge(m_batch);
+  return Error::NONE;
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Delta);
+
+namespace gossip::message {
+
+Summary::Summary(const uint64_t t_root, const uint32_t t_round, const Crdts::Digest t_digest)
+    : m_root(t_root), m_round(t_round), m_digest(t_digest) {}
+
+Error Summary::receive(Gossip &self, const Member t_sender) const {
+  auto &crdts = self.crdts();
+  auto sender_member = make_shared<Member>(t_sender);
+  if (m_round == 0) {
+    if (m_root != crdts.root())
+      self.enqueue_message(Summary{crdts.root(), 1, crdts.digest()}, Spreading::DIRECT, sender_member);
+    return Error::NONE;
+  }
+  if (m_round > 2)
+    return Error::INVALID_MESSAGE;
+
+  auto batch = crdts.diff(m_digest);
+  if (!batch.empty())
+    self.enqueue_message(Delta{batch}, Spreading::DIRECT, sender_member);
+  if (m_round == 1)
+    self.enqueue_message(Summary{crdts.root(), 2, crdts.digest()}, Spreading::DIRECT, sender_member);
+  return Error::NONE;
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Summary);
+
+namespace gossip::message {
+
+Fragment::Fragment(const uint32_t t_transfer,
+                   const uint32_t t_index,
+                   const uint32_t t_count,
+                   const string t_bytes)
+    : m_transfer(t_transfer),
+      m_index(t_index),
+      m_count(t_count),
+      m_bytes(t_bytes) {}
+
+Error Fragment::receive(Gossip &self, const Member t_sender) const {
+  return self.reassemble(t_sender, m_transfer, m_index, m_count, m_bytes);
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Fragment);
+
+namespace gossip::message {
+
+Nack::Nack(const uint32_t t_transfer,
+           const vector<bool> t_missing) : m_transfer(t_transfer), m_missing(t_missing) {}
+
+Error Nack::receive(Gossip &self, const Member t_sender) const {
+  return self.retransmit(t_sender, m_transfer, m_missing);
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Nack);
+
+namespace gossip::message {
+
+Ping::Ping(const uint32_t t_probe,
+           const Member::shared_ptr t_self_member) : m_probe(t_probe), m_self_member(t_self_member) {}
+
+Error Ping::receive(Gossip &self, const Member t_sender) const {
+  // A member reported failed hears so from its next probe and refutes it with a
+  // higher incarnation; until then the tombstone keeps it out.
+  if (m_self_member) {
+    auto tombstone = self.tombstone(m_self_member->uid());
+    if (tombstone && tombstone->incarnation() >= m_self_member->incarnation())
+      self.enqueue_message(Obituary{{*tombstone}}, Spreading::DIRECT, make_shared<Member>(t_sender));
+    self.insert_member(m_self_member);
+  }
+
+  return self.enqueue_message(Ack{m_probe}, Spreading::DIRECT, make_shared<Member>(t_sender));
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Ping);
+
+namespace gossip::message {
+
+Ack::Ack(const uint32_t t_probe) : m_probe(t_probe) {}
+
+Error Ack::receive(Gossip &self, const Member t_sender) const {
+  return self.acknowledge(t_sender, m_probe);
+}
+}; // namespace gossip::message
+
+BOOST_CLASS_EXPORT(gossip::message::Ack);
 
 // namespace gossip::message
 //       m_state = State::CONNECTED;
@@ -1,16 +1,22 @@
 #ifndef MESSAGE_HPP
 #define MESSAGE_HPP
 
+#include <boost/asio/awaitable.hpp>
 #include <boost/serialization/export.hpp>
 #include <boost/serialization/serialization.hpp>
+#include <boost/serialization/version.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/vector.hpp>
 #include <memory>
 #include <string>
 #include <type_traits>
 
+#include "cache.hpp"
+#include "codec.hpp"
+#include "crdt.hpp"
 #include "member.hpp"
 
+using boost::asio::awaitable;
 using std::is_base_of;
 using std::shared_ptr;
 
@@ -52,7 +58,18 @@ public:
 
   Message() = default;
   Message(const Header t_header);
+  virtual ~Message() = default;
   virtual Error receive(Gossip &self, const Member t_sender) const;
+
+  /**
+   * Runs the handler as a coroutine on the node's context. Handlers that wait
+   * on other members override it together with `suspends` and suspend instead
+   * of chaining callbacks; the rest keep `receive`, which this calls.
+   */
+  virtual awaitable<Error> handle(Gossip &self, const Member t_sender) const;
+
+  /** Whether `handle` may wait on another member; only such messages are spawned, the rest are received inline. */
+  virtual bool suspends() const;
 };
 
 template <typename T>
@@ -72,10 +89,17 @@ class Hello : public Message {
   void serialize(Archive &ar, const unsigned int version) {
     ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
     ar &m_self_member;
+    if (version >= 1)
+      ar &m_codecs;
+    if (version >= 2)
+      ar &m_dictionaries;
   };
 
 public:
   Member::shared_ptr m_self_member = nullptr;
+  uint32_t m_codecs = Codec::capabilities;
+  /** The sender's `Codec::dictionaries`; 0 from members that predate it. */
+  uint32_t m_dictionaries = 0;
 
   Hello() = default;
   Hello(const Header t_header);
@@ -87,6 +111,8 @@ public:
 };
 }; // namespace gossip::message
 
+BOOST_CLASS_VERSION(gossip::message::Hello, 2);
+
 namespace gossip::message {
 class Welcome : public Message {
   friend class boost::serialization::access;
@@ -94,16 +120,506 @@ class Welcome : public Message {
   void serialize(Archive &ar, const unsigned int version) {
     ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
     ar &m_self_member;
+    if (version >= 1)
+      ar &m_codecs;
+    if (version >= 2) {
+      ar &m_complete;
+      ar &m_members;
+      ar &m_crdts;
+    }
+    if (version >= 3)
+      ar &m_dictionaries;
   };
 
 public:
   Member::shared_ptr m_self_member = nullptr;
+  uint32_t m_codecs = Codec::capabilities;
+  uint32_t m_dictionaries = 0;
+
+  /** Whether this carries the sender's whole memberlist and CRDT state, the answer to a joining member. */
+  bool m_complete = false;
+  vector<Member> m_members;
+  Crdts::Batch m_crdts;
 
   Welcome() = default;
   Welcome(const Header t_header);
   Welcome(const Member::shared_ptr t_self_member);
   Welcome(const Header t_header,
           const Member::shared_ptr t_self_member);
+  Welcome(const Member::shared_ptr t_self_member,
+          const vector<Member> t_members,
+          const Crdts::Batch t_crdts);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+BOOST_CLASS_VERSION(gossip::message::Welcome, 3);
+
+namespace gossip::message {
+class Get : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_key;
+    ar &m_hops;
+  };
+
+public:
+  string m_key;
+  uint32_t m_hops = 0;
+
+  Get() = default;
+  Get(const Header t_header,
+      const string t_key,
+      const uint32_t t_hops);
+
+  virtual awaitable<Error> handle(Gossip &self, const Member t_sender) const override;
+  virtual bool suspends() const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Set : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_key;
+    ar &m_value;
+    ar &m_hops;
+  };
+
+public:
+  string m_key;
+  string m_value;
+  uint32_t m_hops = 0;
+
+  Set() = default;
+  Set(const Header t_header,
+      const string t_key,
+      const string t_value,
+      const uint32_t t_hops);
+
+  virtual awaitable<Error> handle(Gossip &self, const Member t_sender) const override;
+  virtual bool suspends() const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Value : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_request;
+    ar &m_error;
+    ar &m_found;
+    ar &m_entry;
+  };
+
+public:
+  uint32_t m_request = 0;
+  int32_t m_error = 0;
+  bool m_found = false;
+  Cache::Entry m_entry{};
+
+  Value() = default;
+  Value(const uint32_t t_request,
+        const Error t_error,
+        const optional<Cache::Entry> t_entry);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class MultiGet : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_keys;
+    ar &m_hops;
+  };
+
+public:
+  vector<string> m_keys;
+  uint32_t m_hops = 0;
+
+  MultiGet() = default;
+  MultiGet(const Header t_header,
+           const vector<string> t_keys,
+           const uint32_t t_hops);
+
+  virtual awaitable<Error> handle(Gossip &self, const Member t_sender) const override;
+  virtual bool suspends() const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class MultiSet : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_items;
+    ar &m_hops;
+  };
+
+public:
+  vector<pair<string, string>> m_items;
+  uint32_t m_hops = 0;
+
+  MultiSet() = default;
+  MultiSet(const Header t_header,
+           const vector<pair<string, string>> t_items,
+           const uint32_t t_hops);
+
+  virtual awaitable<Error> handle(Gossip &self, const Member t_sender) const override;
+  virtual bool suspends() const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class MultiValue : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_request;
+    ar &m_errors;
+    ar &m_found;
+    ar &m_entries;
+  };
+
+public:
+  uint32_t m_request = 0;
+  vector<int32_t> m_errors;
+  vector<bool> m_found;
+  vector<Cache::Entry> m_entries;
+
+  MultiValue() = default;
+  MultiValue(const uint32_t t_request,
+             const vector<pair<Error, optional<Cache::Entry>>> t_results);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Digest : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_membership;
+    ar &m_nodes;
+  };
+
+public:
+  class Node {
+    friend class boost::serialization::access;
+    template <class Archive>
+    void serialize(Archive &ar, const unsigned int version) {
+      ar &partition;
+      ar &index;
+      ar &hash;
+    }
+
+  public:
+    uint32_t partition = 0;
+    uint32_t index = 0;
+    uint64_t hash = 0;
+
+    Node() = default;
+    Node(const uint32_t t_partition,
+         const uint32_t t_index,
+         const uint64_t t_hash);
+  };
+
+  uint64_t m_membership = 0;
+  vector<Node> m_nodes;
+
+  Digest() = default;
+  Digest(const uint64_t t_membership,
+         const vector<Node> t_nodes);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Entries : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_partition;
+    ar &m_leaf;
+    ar &m_entries;
+    ar &m_reply;
+  };
+
+public:
+  uint32_t m_partition = 0;
+  uint32_t m_leaf = 0;
+  Cache::Range m_entries;
+  bool m_reply = false;
+
+  Entries() = default;
+  Entries(const uint32_t t_partition,
+          const uint32_t t_leaf,
+          const Cache::Range t_entries,
+          const bool t_reply);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Memberlist : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_members;
+  };
+
+public:
+  vector<Member> m_members;
+
+  Memberlist() = default;
+  Memberlist(const vector<Member> t_members);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+/** Members reported failed, each at the incarnation it failed at; spread like a membership rumor. */
+class Obituary : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_members;
+  };
+
+public:
+  vector<Member> m_members;
+
+  Obituary() = default;
+  Obituary(const vector<Member> t_members);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+/**
+ * The uids a member knows, sent when membership digests differ. The receiver
+ * answers with a Memberlist of only the members missing from it and, when
+ * `m_reply` is set and it lacks some itself, with its own roster in turn.
+ */
+class Roster : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_members;
+    ar &m_reply;
+  };
+
+public:
+  vector<uuid> m_members;
+  bool m_reply = false;
+
+  Roster() = default;
+  Roster(const vector<uuid> t_members, const bool t_reply);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Hot : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_key;
+    ar &m_entry;
+    ar &m_ttl;
+  };
+
+public:
+  string m_key;
+  Cache::Entry m_entry{};
+  int32_t m_ttl = 0;
+
+  Hot() = default;
+  Hot(const string t_key,
+      const Cache::Entry t_entry,
+      const int32_t t_ttl);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Invalidate : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_keys;
+  };
+
+public:
+  vector<string> m_keys;
+
+  Invalidate() = default;
+  Invalidate(const vector<string> t_keys);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Delta : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_batch;
+  };
+
+public:
+  Crdts::Batch m_batch;
+
+  Delta() = default;
+  Delta(const Crdts::Batch t_batch);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+/**
+ * Compares CRDTs in rounds that stop as soon as nothing differs: round 0 carries
+ * only the root, round 1 the sender's digest with an answer wanted, and round 2
+ * the answer. Each side sends a Delta of the keys the other's digest disagrees on.
+ */
+class Summary : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_root;
+    ar &m_round;
+    ar &m_digest;
+  };
+
+public:
+  uint64_t m_root = 0;
+  uint32_t m_round = 0;
+  Crdts::Digest m_digest;
+
+  Summary() = default;
+  Summary(const uint64_t t_root, const uint32_t t_round, const Crdts::Digest t_digest);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Fragment : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_transfer;
+    ar &m_index;
+    ar &m_count;
+    ar &m_bytes;
+  };
+
+public:
+  uint32_t m_transfer = 0;
+  uint32_t m_index = 0;
+  uint32_t m_count = 0;
+  string m_bytes;
+
+  Fragment() = default;
+  Fragment(const uint32_t t_transfer,
+           const uint32_t t_index,
+           const uint32_t t_count,
+           const string t_bytes);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Nack : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_transfer;
+    ar &m_missing;
+  };
+
+public:
+  uint32_t m_transfer = 0;
+  vector<bool> m_missing;
+
+  Nack() = default;
+  Nack(const uint32_t t_transfer,
+       const vector<bool> t_missing);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Ping : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_probe;
+    ar &m_self_member;
+  };
+
+public:
+  uint32_t m_probe = 0;
+  Member::shared_ptr m_self_member = nullptr;
+
+  Ping() = default;
+  Ping(const uint32_t t_probe,
+       const Member::shared_ptr t_self_member);
+
+  virtual Error receive(Gossip &self, const Member t_sender) const override;
+};
+}; // namespace gossip::message
+
+namespace gossip::message {
+class Ack : public Message {
+  friend class boost::serialization::access;
+  template <class Archive>
+  void serialize(Archive &ar, const unsigned int version) {
+    ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
+    ar &m_probe;
+  };
+
+public:
+  uint32_t m_probe = 0;
+
+  Ack() = default;
+  Ack(const uint32_t t_probe);
 
   virtual Error receive(Gossip &self, const Member t_sender) const override;
 };
@@ -125,20 +641,6 @@ public:
 //   Welcome(Member::shared_ptr t_self_member = nullptr, uint32_t hello_sequence = 0, Header header = Header());
 // };
 
-// class Memberlist : public Message {
-//   friend class boost::serialization::access;
-//   template <class Archive>
-//   void serialize(Archive &ar, const unsigned int version) {
-//     ar &BOOST_SERIALIZATION_BASE_OBJECT_NVP(Message);
-//     ar &members;
-//   };
-
-// public:
-//   vector<Member> members;
-
-//   Memberlist(map<string, Member::shared_ptr> t_members = map<string, Member::shared_ptr>(), Header header = Header());
-// };
-
 // class Ack : public Message {
 //   friend class boost::serialization::access;
 //   template <class Archive>
@@ -0,0 +1,185 @@
+#include <boost/asio.hpp>
+#include <boost/log/trivial.hpp>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "metrics.hpp"
+
+using boost::asio::async_read_until;
+using boost::asio::async_write;
+using boost::asio::buffer;
+using boost::asio::dynamic_buffer;
+using boost::system::error_code;
+using std::lock_guard;
+using std::make_shared;
+using std::make_unique;
+using std::mutex;
+using std::ostringstream;
+using std::shared_ptr;
+
+namespace gossip {
+namespace {
+
+/** `name{labels}`, or the bare name for an unlabelled series. */
+string series(const string &t_name, const string &t_labels, const string &t_extra = "") {
+  string labels = t_labels;
+  if (!t_extra.empty())
+    labels += (labels.empty() ? "" : ",") + t_extra;
+  return labels.empty() ? t_name : t_name + "{" + labels + "}";
+}
+
+} // namespace
+
+uint64_t Counter::value() const {
+  uint64_t total = 0;
+  for (const auto &shard : m_shards)
+    total += shard.value.load(std::memory_order_relaxed);
+  return total;
+}
+
+void Counter::write(std::ostream &t_out, const string &t_name, const string &t_labels) const {
+  t_out << series(t_name, t_labels) << " " << value() << "\n";
+}
+
+int64_t Gauge::value() const { return m_value.load(std::memory_order_relaxed); }
+
+void Gauge::write(std::ostream &t_out, const string &t_name, const string &t_labels) const {
+  t_out << series(t_name, t_labels) << " " << value() << "\n";
+}
+
+Latency::Buckets Latency::snapshot() const {
+  Buckets merged;
+  for (const auto &shard : m_shards)
+    for (uint32_t i = 0; i < Buckets::bucket_count; ++i)
+      if (auto count = shard.counts[i].load(std::memory_order_relaxed))
+        merged.record(Buckets::value_of(i), count);
+  return merged;
+}
+
+void Latency::write(std::ostream &t_out, const string &t_name, const string &t_labels) const {
+  array<uint64_t, Buckets::bucket_count> counts{};
+  uint64_t sum = 0;
+  for (const auto &shard : m_shards) {
+    for (uint32_t i = 0; i < Buckets::bucket_count; ++i)
+      counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+    sum += shard.sum.load(std::memory_order_relaxed);
+  }
+
+  // One `le` per power of two between the smallest and largest sample keeps
+  // the dump short while the sub-buckets stay available to `snapshot`.
+  uint32_t first = Buckets::bucket_count, last = 0;
+  for (uint32_t i = 0; i < Buckets::bucket_count; ++i) {
+    if (!counts[i])
+      continue;
+    first = std::min(first, i);
+    last = i;
+  }
+
+  uint64_t seen = 0;
+  if (first < Buckets::bucket_count) {
+    for (uint32_t i = 0; i <= last; ++i) {
+      seen += counts[i];
+      bool edge = i % Buckets::sub_buckets == Buckets::sub_buckets - 1 || i == last;
+      if (!edge || i < first)
+        continue;
+      ostringstream le;
+      le << "le=\"" << std::setprecision(6) << (Buckets::value_of(i) + 1) / 1e9 << "\"";
+      t_out << series(t_name + "_bucket", t_labels, le.str()) << " " << seen << "\n";
+    }
+  }
+
+  t_out << series(t_name + "_bucket", t_labels, "le=\"+Inf\"") << " " << seen << "\n";
+  t_out << series(t_name + "_sum", t_labels) << " " << sum / 1e9 << "\n";
+  t_out << series(t_name + "_count", t_labels) << " " << seen << "\n";
+}
+
+template <typename IMetric>
+IMetric &Metrics::m_series(const string &t_name, const string &t_help, const string &t_type, const string &t_labels) {
+  lock_guard<mutex> lock(m_mutex);
+  auto &family = m_families[t_name];
+  if (family.type.empty()) {
+    family.help = t_help;
+    family.type = t_type;
+  }
+
+  auto &metric = family.series[t_labels];
+  if (!metric)
+    metric = make_unique<IMetric>();
+  return static_cast<IMetric &>(*metric);
+}
+
+Counter &Metrics::counter(const string &t_name, const string &t_help, const string &t_labels) {
+  return m_series<Counter>(t_name, t_help, "counter", t_labels);
+}
+
+Gauge &Metrics::gauge(const string &t_name, const string &t_help, const string &t_labels) {
+  return m_series<Gauge>(t_name, t_help, "gauge", t_labels);
+}
+
+Latency &Metrics::latency(const string &t_name, const string &t_help, const string &t_labels) {
+  return m_series<Latency>(t_name, t_help, "histogram", t_labels);
+}
+
+void Metrics::erase(const string &t_name, const string &t_labels) {
+  lock_guard<mutex> lock(m_mutex);
+  auto it = m_families.find(t_name);
+  if (it != m_families.end())
+    it->second.series.erase(t_labels);
+}
+
+string Metrics::text() const {
+  ostringstream out;
+  lock_guard<mutex> lock(m_mutex);
+  for (const auto &[name, family] : m_families) {
+    out << "# HELP " << name << " " << family.help << "\n";
+    out << "# TYPE " << name << " " << family.type << "\n";
+    for (const auto &[labels, metric] : family.series)
+      metric->write(out, name, labels);
+  }
+  return out.str();
+}
+
+Exporter::Exporter(const Metrics &t_metrics, const tcp::endpoint &t_endpoint)
+    : m_metrics(t_metrics), m_acceptor(m_context, t_endpoint) {
+  m_accept();
+  m_thread = std::thread([this]() { m_context.run(); });
+}
+
+Exporter::~Exporter() {
+  m_context.stop();
+  m_thread.join();
+}
+
+void Exporter::m_accept() {
+  m_acceptor.async_accept([this](const error_code ec, tcp::socket t_socket) {
+    if (ec) {
+      BOOST_LOG_TRIVIAL(error) << "Exporter::m_accept:"
+                               << "\t[error]:" << ec.message();
+      return;
+    }
+
+    auto socket = make_shared<tcp::socket>(std::move(t_socket));
+    auto request = make_shared<string>();
+    async_read_until(*socket, dynamic_buffer(*request), "\r\n\r\n",
+                     [this, socket, request](const error_code ec, const size_t length) {
+                       if (ec)
+                         return;
+
+                       auto body = m_metrics.text();
+                       auto response = make_shared<string>("HTTP/1.0 200 OK\r\n"
+                                                           "Content-Type: text/plain; version=0.0.4\r\n"
+                                                           "Content-Length: " +
+                                                           std::to_string(body.size()) + "\r\n\r\n" + body);
+                       async_write(*socket, buffer(*response),
+                                   [socket, response](const error_code ec, const size_t length) {
+                                     error_code ignored;
+                                     socket->shutdown(tcp::socket::shutdown_both, ignored);
+                                   });
+                     });
+    m_accept();
+  });
+}
+
+}; // namespace gossip
@@ -0,0 +1,156 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "histogram.hpp"
+
+using boost::asio::io_context;
+using boost::asio::ip::tcp;
+using std::array;
+using std::atomic;
+using std::map;
+using std::string;
+
+namespace gossip {
+
+/** One named series, able to print itself in the Prometheus text format. */
+class Metric {
+public:
+  virtual ~Metric() = default;
+  virtual void write(std::ostream &t_out, const string &t_name, const string &t_labels) const = 0;
+};
+
+/**
+ * Events are spread over a few shards, each on its own cache line, so threads
+ * incrementing one counter do not bounce a line between cores. A thread keeps
+ * the shard it was given on first use; readers sum the shards without locking.
+ */
+class Shards {
+public:
+  static const size_t count = 4;
+
+  /** The shard of the calling thread. */
+  static size_t mine() {
+    static atomic<size_t> next{0};
+    thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % count;
+    return shard;
+  }
+};
+
+/** A monotonically increasing count of events. */
+class Counter : public Metric {
+  struct alignas(64) Shard {
+    atomic<uint64_t> value{0};
+  };
+
+  array<Shard, Shards::count> m_shards;
+
+public:
+  void add(const uint64_t t_value = 1) { m_shards[Shards::mine()].value.fetch_add(t_value, std::memory_order_relaxed); }
+  uint64_t value() const;
+
+  virtual void write(std::ostream &t_out, const string &t_name, const string &t_labels) const override;
+};
+
+/** A level sampled by its owner, such as a queue depth. */
+class Gauge : public Metric {
+  alignas(64) atomic<int64_t> m_value{0};
+
+public:
+  void set(const int64_t t_value) { m_value.store(t_value, std::memory_order_relaxed); }
+  int64_t value() const;
+
+  virtual void write(std::ostream &t_out, const string &t_name, const string &t_labels) const override;
+};
+
+/**
+ * A log-bucketed histogram of durations in nanoseconds, exported in seconds.
+ * Buckets follow `Histogram<2>`, so a sample is off by at most a quarter.
+ */
+class Latency : public Metric {
+public:
+  typedef Histogram<2> Buckets;
+
+private:
+  struct alignas(64) Shard {
+    array<atomic<uint64_t>, Buckets::bucket_count> counts{};
+    atomic<uint64_t> sum{0};
+  };
+
+  array<Shard, Shards::count> m_shards;
+
+public:
+  void record(const std::chrono::nanoseconds t_latency) {
+    auto value = (uint64_t)std::max<int64_t>(0, t_latency.count());
+    auto &shard = m_shards[Shards::mine()];
+    shard.counts[Buckets::index_of(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /** The shards merged into one histogram, for percentiles. */
+  Buckets snapshot() const;
+
+  virtual void write(std::ostream &t_out, const string &t_name, const string &t_labels) const override;
+};
+
+/**
+ * Named metrics, each a family of series told apart by a label string such as
+ * `type="Hello"`. Registration takes a lock and returns a reference that stays
+ * valid until the series is erased; callers keep it and update it lock-free.
+ */
+class Metrics {
+  struct Family {
+    string help;
+    string type;
+    map<string, std::unique_ptr<Metric>> series;
+  };
+
+  mutable std::mutex m_mutex;
+  map<string, Family> m_families;
+
+  template <typename IMetric>
+  IMetric &m_series(const string &t_name, const string &t_help, const string &t_type, const string &t_labels);
+
+public:
+  Counter &counter(const string &t_name, const string &t_help, const string &t_labels = "");
+  Gauge &gauge(const string &t_name, const string &t_help, const string &t_labels = "");
+  Latency &latency(const string &t_name, const string &t_help, const string &t_labels = "");
+
+  /** Drops one series, e.g. of a removed member. References to it dangle afterwards. */
+  void erase(const string &t_name, const string &t_labels);
+
+  /** Every series in the Prometheus text exposition format. */
+  string text() const;
+};
+
+/**
+ * Serves `Metrics::text` over HTTP on its own thread, so a scrape never waits
+ * on or delays the node's event loop. Every request gets the full dump.
+ */
+class Exporter {
+  const Metrics &m_metrics;
+  io_context m_context;
+  tcp::acceptor m_acceptor;
+  std::thread m_thread;
+
+  void m_accept();
+
+public:
+  Exporter(const Metrics &t_metrics, const tcp::endpoint &t_endpoint);
+  ~Exporter();
+};
+
+}; // namespace gossip
+
+#endif
@@ -0,0 +1,730 @@
+#include <algorithm>
+#include <array>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/asio.hpp>
+#include <boost/crc.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/log/trivial.hpp>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "gossip.hpp"
+#include "migration.hpp"
+
+using boost::archive::text_iarchive;
+using boost::archive::text_oarchive;
+using boost::asio::async_read;
+using boost::asio::async_write;
+using boost::asio::buffer;
+using boost::asio::io_context;
+using boost::asio::steady_timer;
+using boost::asio::ip::tcp;
+using boost::endian::big_to_native;
+using boost::endian::native_to_big;
+using boost::iostreams::back_insert_device;
+using boost::iostreams::stream;
+using boost::system::error_code;
+using std::any_of;
+using std::array;
+using std::deque;
+using std::enable_shared_from_this;
+using std::istringstream;
+using std::make_shared;
+using std::max;
+using std::min;
+using std::optional;
+using std::shared_ptr;
+using std::string;
+using std::chrono::duration;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace gossip {
+namespace {
+
+enum class Frame : uint8_t {
+  CHUNK = 1,
+  COMMIT = 2,
+  ACK = 3,
+  MESSAGE = 4,
+  HELLO = 5,
+  REFUSE = 6
+};
+
+struct FrameHeader {
+  Frame type;
+  uint32_t partition;
+  uint32_t sequence;
+  uint32_t length;
+  uint32_t checksum;
+};
+
+const size_t frame_header_size = 17;
+const uint32_t frame_max_length = 64 << 20;
+
+uint32_t checksum(const string &t_payload) {
+  boost::crc_32_type crc;
+  crc.process_bytes(t_payload.data(), t_payload.size());
+  return crc.checksum();
+}
+
+void put(char *t_out, const uint32_t t_value) {
+  uint32_t value = native_to_big(t_value);
+  std::memcpy(t_out, &value, sizeof(value));
+}
+
+uint32_t take(const char *t_in) {
+  uint32_t value;
+  std::memcpy(&value, t_in, sizeof(value));
+  return big_to_native(value);
+}
+
+string encode(const Frame t_type,
+              const uint32_t t_partition,
+              const uint32_t t_sequence,
+              const string &t_payload = "") {
+  string frame(frame_header_size, '\0');
+  frame[0] = (char)t_type;
+  put(&frame[1], t_partition);
+  put(&frame[5], t_sequence);
+  put(&frame[9], (uint32_t)t_payload.size());
+  put(&frame[13], checksum(t_payload));
+  return frame + t_payload;
+}
+
+FrameHeader decode(const char *t_in) {
+  return FrameHeader{(Frame)t_in[0], take(t_in + 1), take(t_in + 5), take(t_in + 9), take(t_in + 13)};
+}
+
+string serialize(const Cache::Range &t_range) {
+  string serial_str;
+  back_insert_device<string> inserter(serial_str);
+  stream<back_insert_device<string>> s(inserter);
+  text_oarchive oa(s);
+  oa << t_range;
+  s.flush();
+  return serial_str;
+}
+
+Cache::Range deserialize(const string &t_payload) {
+  istringstream iss(t_payload);
+  text_iarchive ia(iss);
+  Cache::Range range;
+  ia >> range;
+  return range;
+}
+
+bool same(const Member::shared_ptr &t_lhs, const Member::shared_ptr &t_rhs) {
+  if (!t_lhs || !t_rhs)
+    return t_lhs == t_rhs;
+  return t_lhs->uid() == t_rhs->uid();
+}
+} // namespace
+
+class Migration::Outbound : public enable_shared_from_this<Migration::Outbound> {
+  Migration &m_migration;
+  Member::shared_ptr m_target;
+  tcp::socket m_socket;
+  steady_timer m_timer;
+
+  deque<uint32_t> m_partitions;
+  optional<string> m_cursor;
+  bool m_scanned = false;
+  bool m_committing = false;
+  uint32_t m_commit = 0;
+  uint32_t m_sequence = 0;
+  uint32_t m_acked = 0;
+
+  bool m_connecting = false;
+  bool m_connected = false;
+  bool m_waiting = false;
+  bool m_writing = false;
+  deque<string> m_writes;
+  deque<string> m_backlog;
+  array<char, frame_header_size> m_ack{};
+
+  double m_tokens = 0;
+  steady_clock::time_point m_refill;
+
+  void m_connect() {
+    m_connecting = true;
+    auto self = shared_from_this();
+    tcp::endpoint endpoint(m_target->address().address(), m_target->address().port());
+    m_socket.async_connect(endpoint, [self](const error_code ec) {
+      self->m_connecting = false;
+      if (ec) {
+        BOOST_LOG_TRIVIAL(error) << "Migration::Outbound::m_connect:"
+                                 << "\t[address]:" << self->m_target->address()
+                                 << "\t[error]:" << ec.message();
+        self->m_retry();
+        return;
+      }
+
+      self->m_connected = true;
+      self->m_write(encode(Frame::HELLO, 0, 0, self->m_migration.m_hello()));
+      while (!self->m_backlog.empty()) {
+        self->m_write(self->m_backlog.front());
+        self->m_backlog.pop_front();
+      }
+      self->m_read();
+      self->m_pump();
+    });
+  }
+
+  void m_retry() {
+    if (m_connecting)
+      return;
+
+    error_code ignored;
+    m_socket.close(ignored);
+    m_timer.cancel();
+    m_connected = false;
+    m_waiting = false;
+    m_writing = false;
+    m_writes.clear();
+    m_cursor.reset();
+    m_scanned = false;
+    m_committing = false;
+    m_sequence = m_acked = 0;
+
+    m_connecting = true;
+    auto self = shared_from_this();
+    m_timer.expires_after(milliseconds(m_migration.m_gossip.message_retry_interval()));
+    m_timer.async_wait([self](const error_code ec) {
+      self->m_connecting = false;
+      if (!ec && (!self->m_partitions.empty() || !self->m_backlog.empty()))
+        self->m_connect();
+    });
+  }
+
+  bool m_take() {
+    auto now = m_migration.m_gossip.clock().now();
+    double rate = max(m_migration.rate(), 1);
+    m_tokens = min(m_tokens + duration<double>(now - m_refill).count() * rate,
+                   (double)m_migration.chunk_size() * 2);
+    m_refill = now;
+    if (m_tokens >= m_migration.chunk_size())
+      return true;
+
+    m_waiting = true;
+    auto self = shared_from_this();
+    auto wait = duration<double>((m_migration.chunk_size() - m_tokens) / rate);
+    m_timer.expires_after(duration_cast<milliseconds>(wait) + milliseconds(1));
+    m_timer.async_wait([self](const error_code ec) {
+      self->m_waiting = false;
+      if (!ec)
+        self->m_pump();
+    });
+    return false;
+  }
+
+  void m_pump() {
+    Cache &cache = m_migration.m_gossip.cache();
+    while (m_connected && !m_waiting && !m_committing && !m_partitions.empty() &&
+           m_sequence - m_acked < (uint32_t)m_migration.window()) {
+      uint32_t partition = m_partitions.front();
+      set<string> &dirty = m_migration.m_outbound[partition].dirty;
+
+      if (m_scanned && dirty.empty()) {
+        m_committing = true;
+        m_commit = ++m_sequence;
+        m_write(encode(Frame::COMMIT, partition, m_commit));
+        return;
+      }
+
+      if (!m_take())
+        return;
+
+      Cache::Range range;
+      if (!m_scanned) {
+        range = cache.scan(partition, m_cursor, m_migration.chunk_size());
+        if (range.empty()) {
+          m_scanned = true;
+          continue;
+        }
+        m_cursor = range.back().first;
+      } else {
+        size_t bytes = 0;
+        while (!dirty.empty() && bytes < (size_t)m_migration.chunk_size()) {
+          auto key = dirty.extract(dirty.begin()).value();
+          if (auto entry = cache.get(key)) {
+            bytes += key.size() + entry->value.size();
+            range.emplace_back(key, *entry);
+          }
+        }
+      }
+
+      string payload = serialize(range);
+      m_tokens -= payload.size();
+      m_write(encode(Frame::CHUNK, partition, ++m_sequence, payload));
+    }
+  }
+
+  void m_write(const string t_frame) {
+    m_writes.push_back(t_frame);
+    if (!m_writing)
+      m_flush();
+  }
+
+  void m_flush() {
+    m_writing = true;
+    auto self = shared_from_this();
+    async_write(m_socket, buffer(m_writes.front()), [self](const error_code ec, const size_t length) {
+      if (ec) {
+        if (ec != boost::asio::error::operation_aborted)
+          self->m_retry();
+        return;
+      }
+
+      self->m_writes.pop_front();
+      if (self->m_writes.empty())
+        self->m_writing = false;
+      else
+        self->m_flush();
+    });
+  }
+
+  void m_read() {
+    auto self = shared_from_this();
+    async_read(m_socket, buffer(m_ack), [self](const error_code ec, const size_t length) {
+      if (ec) {
+        if (ec != boost::asio::error::operation_aborted)
+          self->m_retry();
+        return;
+      }
+
+      FrameHeader header = decode(self->m_ack.data());
+      if (header.type == Frame::ACK)
+        self->m_acknowledge(header);
+      else if (header.type == Frame::REFUSE)
+        self->m_refused(header);
+
+      self->m_read();
+      self->m_pump();
+    });
+  }
+
+  void m_acknowledge(const FrameHeader &t_header) {
+    m_acked = max(m_acked, t_header.sequence);
+    if (!m_committing || t_header.sequence != m_commit)
+      return;
+
+    m_committing = false;
+    uint32_t partition = m_partitions.front();
+    if (!m_migration.m_outbound[partition].dirty.empty())
+      return;
+
+    Gossip &gossip = m_migration.m_gossip;
+    m_migration.m_outbound.erase(partition);
+    if (!gossip.replicates(partition))
+      gossip.cache().drop(partition);
+
+    BOOST_LOG_TRIVIAL(info) << "Migration::Outbound::m_acknowledge:"
+                            << "\t[partition]:" << partition
+                            << "\t[address]:" << m_target->address();
+
+    m_partitions.pop_front();
+    m_cursor.reset();
+    m_scanned = false;
+  }
+
+  void m_refused(const FrameHeader &t_header) {
+    m_acked = max(m_acked, t_header.sequence);
+    if (m_partitions.empty() || m_partitions.front() != t_header.partition)
+      return;
+
+    // Every chunk was taken and only the commit is left to the member the target pulls from,
+    // so the handover is done here.
+    if (m_committing && t_header.sequence == m_commit) {
+      m_acknowledge(t_header);
+      return;
+    }
+
+    // The target does not own the partition yet. This member keeps the data and offers
+    // it again later, while the partitions behind it go ahead.
+    uint32_t partition = m_partitions.front();
+    m_partitions.pop_front();
+    m_cursor.reset();
+    m_scanned = false;
+    m_committing = false;
+
+    BOOST_LOG_TRIVIAL(info) << "Migration::Outbound::m_refused:"
+                            << "\t[partition]:" << partition
+                            << "\t[address]:" << m_target->address();
+
+    auto self = shared_from_this();
+    auto timer = make_shared<steady_timer>(m_timer.get_executor());
+    timer->expires_after(milliseconds(m_migration.m_gossip.message_retry_interval()));
+    timer->async_wait([self, timer, partition](const error_code ec) {
+      auto transfer = self->m_migration.m_outbound.find(partition);
+      if (ec || transfer == self->m_migration.m_outbound.end() || !same(transfer->second.target, self->m_target) ||
+          std::find(self->m_partitions.begin(), self->m_partitions.end(), partition) != self->m_partitions.end())
+        return;
+      self->enqueue(partition);
+    });
+  }
+
+public:
+  Outbound(Migration &t_migration, const Member::shared_ptr t_target, io_context &t_context)
+      : m_migration(t_migration),
+        m_target(t_target),
+        m_socket(t_context),
+        m_timer(t_context),
+        m_refill(t_migration.m_gossip.clock().now()) {}
+
+  void enqueue(const uint32_t t_partition) {
+    m_partitions.push_back(t_partition);
+    if (m_connected)
+      m_pump();
+    else if (!m_connecting)
+      m_connect();
+  }
+
+  /** Stops streaming a partition; chunks already sent are left to the target to discard. */
+  void cancel(const uint32_t t_partition) {
+    auto it = std::find(m_partitions.begin(), m_partitions.end(), t_partition);
+    if (it == m_partitions.end())
+      return;
+
+    if (it == m_partitions.begin()) {
+      m_cursor.reset();
+      m_scanned = false;
+      m_committing = false;
+    }
+    m_partitions.erase(it);
+    m_pump();
+  }
+
+  /** Gives up on the target for good, dropping everything queued for it. */
+  void close() {
+    m_partitions.clear();
+    m_backlog.clear();
+    m_writes.clear();
+    m_timer.cancel();
+    error_code ignored;
+    m_socket.close(ignored);
+    m_connected = false;
+  }
+
+  void send(const string t_frame) {
+    if (m_connected) {
+      m_write(t_frame);
+      return;
+    }
+
+    m_backlog.push_back(t_frame);
+    if (!m_connecting)
+      m_connect();
+  }
+};
+
+class Migration::Inbound : public enable_shared_from_this<Migration::Inbound> {
+  Migration &m_migration;
+  tcp::socket m_socket;
+  Member::shared_ptr m_sender;
+  array<char, frame_header_size> m_header{};
+  string m_payload;
+  deque<string> m_writes;
+  bool m_writing = false;
+
+  void m_read_header() {
+    auto self = shared_from_this();
+    async_read(m_socket, buffer(m_header), [self](const error_code ec, const size_t length) {
+      if (ec)
+        return;
+
+      FrameHeader header = decode(self->m_header.data());
+      if (header.length > frame_max_length) {
+        BOOST_LOG_TRIVIAL(error) << "Migration::Inbound::m_read_header:"
+                                 << "\t[length]:" << header.length;
+        self->m_socket.close();
+        return;
+      }
+
+      self->m_payload.resize(header.length);
+      async_read(self->m_socket, buffer(self->m_payload), [self, header](const error_code ec, const size_t length) {
+        if (ec)
+          return;
+
+        try {
+          self->m_handle(header);
+        } catch (const std::exception &e) {
+          BOOST_LOG_TRIVIAL(error) << "Migration::Inbound::m_handle:"
+                                   << "\t[partition]:" << header.partition
+                                   << "\t[error]:" << e.what();
+          error_code ignored;
+          self->m_socket.close(ignored);
+        }
+      });
+    });
+  }
+
+  void m_handle(const FrameHeader t_header) {
+    if (checksum(m_payload) != t_header.checksum) {
+      BOOST_LOG_TRIVIAL(error) << "Migration::Inbound::m_handle:"
+                               << "\t[partition]:" << t_header.partition
+                               << "\t[sequence]:" << t_header.sequence
+                               << "\t checksum mismatch";
+      m_socket.close();
+      return;
+    }
+
+    // Only the member a partition is pulled from may commit it, so a stream that
+    // rebalance cancelled or redirected cannot end the pull early. Chunks are merged
+    // by version, so any member may add to a partition this node owns. Anything else
+    // is refused and offered again later.
+    if (t_header.type == Frame::CHUNK || t_header.type == Frame::COMMIT) {
+      if (!m_sender) {
+        error_code ignored;
+        m_socket.close(ignored);
+        return;
+      }
+      auto &gossip = m_migration.m_gossip;
+      auto source = m_migration.source(t_header.partition);
+      bool owned = t_header.partition < Cache::partition_count && gossip.owner(t_header.partition) == gossip.self_member();
+      bool accepted = t_header.type == Frame::CHUNK || !source ? owned : source->address() == m_sender->address();
+      if (!accepted) {
+        m_write(encode(Frame::REFUSE, t_header.partition, t_header.sequence));
+        m_read_header();
+        return;
+      }
+    }
+
+    switch (t_header.type) {
+      case Frame::CHUNK: {
+        Cache &cache = m_migration.m_gossip.cache();
+        for (const auto &[key, entry] : deserialize(m_payload))
+          cache.apply(key, entry);
+        break;
+      }
+      case Frame::COMMIT:
+        m_migration.m_inbound.erase(t_header.partition);
+        BOOST_LOG_TRIVIAL(info) << "Migration::Inbound::m_handle:"
+                                << "\t[partition]:" << t_header.partition
+                                << "\t committed";
+        break;
+      case Frame::HELLO: {
+        // The peer names its gossip address, which must be on the host the connection comes from.
+        auto sender = make_shared<Member>(m_payload);
+        if (sender->address().address() != m_socket.remote_endpoint().address()) {
+          BOOST_LOG_TRIVIAL(error) << "Migration::Inbound::m_handle:"
+                                   << "\t[address]:" << sender->address()
+                                   << "\t[remote]:" << m_socket.remote_endpoint()
+                                   << "\t address mismatch";
+          error_code ignored;
+          m_socket.close(ignored);
+          return;
+        }
+        m_sender = sender;
+        m_read_header();
+        return;
+      }
+      case Frame::MESSAGE:
+        if (!m_sender) {
+          error_code ignored;
+          m_socket.close(ignored);
+          return;
+        }
+        m_migration.m_gossip.deliver(m_payload, *m_sender);
+        m_read_header();
+        return;
+      case Frame::ACK:
+      case Frame::REFUSE:
+        break;
+    }
+
+    m_write(encode(Frame::ACK, t_header.partition, t_header.sequence));
+    m_read_header();
+  }
+
+  void m_write(const string t_frame) {
+    m_writes.push_back(t_frame);
+    if (!m_writing)
+      m_flush();
+  }
+
+  void m_flush() {
+    m_writing = true;
+    auto self = shared_from_this();
+    async_write(m_socket, buffer(m_writes.front()), [self](const error_code ec, const size_t length) {
+      if (ec)
+        return;
+
+      self->m_writes.pop_front();
+      if (self->m_writes.empty())
+        self->m_writing = false;
+      else
+        self->m_flush();
+    });
+  }
+
+public:
+  Inbound(Migration &t_migration, tcp::socket t_socket)
+      : m_migration(t_migration),
+        m_socket(std::move(t_socket)) {}
+
+  void start() { m_read_header(); }
+};
+
+Migration::Migration(Gossip &t_gossip) : m_gossip(t_gossip) {}
+
+void Migration::start(const tcp::endpoint t_endpoint) {
+  m_acceptor = make_shared<tcp::acceptor>(m_gossip.context(), t_endpoint);
+  m_accept();
+}
+
+void Migration::m_accept() {
+  m_acceptor->async_accept([this](const error_code ec, tcp::socket t_socket) {
+    if (ec) {
+      BOOST_LOG_TRIVIAL(error) << "Migration::m_accept:"
+                               << "\t[error]:" << ec.message();
+      return;
+    }
+
+    make_shared<Inbound>(*this, std::move(t_socket))->start();
+    m_accept();
+  });
+}
+
+shared_ptr<Migration::Outbound> Migration::m_session(const Member::shared_ptr t_target) {
+  auto &session = m_sessions[t_target->uid()];
+  if (!session)
+    session = make_shared<Outbound>(*this, t_target, m_gossip.context());
+  return session;
+}
+
+string Migration::m_hello() const {
+  const auto &address = m_gossip.self_member()->address();
+  return address.address().to_string() + " " + std::to_string(address.port());
+}
+
+set<uint32_t> Migration::m_redirect(const vector<Member::shared_ptr> &t_after) {
+  const auto &self = m_gossip.self_member();
+  const auto &memberlist = m_gossip.memberlist();
+  set<uint32_t> redirected;
+
+  for (auto it = m_outbound.begin(); it != m_outbound.end();) {
+    auto partition = it->first;
+    redirected.insert(partition);
+    auto &transfer = it->second;
+    const auto &after = partition < t_after.size() ? t_after[partition] : self;
+    if (same(after, transfer.target)) {
+      ++it;
+      continue;
+    }
+
+    m_session(transfer.target)->cancel(partition);
+    if (same(after, self)) {
+      BOOST_LOG_TRIVIAL(info) << "Migration::rebalance:"
+                              << "\t[partition]:" << partition
+                              << "\t transfer cancelled";
+      it = m_outbound.erase(it);
+      continue;
+    }
+
+    // The new owner needs a full scan; keys recorded for the old target are covered by it.
+    transfer = Transfer{after, {}};
+    m_session(after)->enqueue(partition);
+    ++it;
+  }
+
+  for (auto it = m_sessions.begin(); it != m_sessions.end();) {
+    bool alive = any_of(memberlist.begin(), memberlist.end(), [&it](const Member::shared_ptr &t_member) {
+      return t_member->uid() == it->first;
+    });
+    if (alive) {
+      ++it;
+      continue;
+    }
+
+    it->second->close();
+    it = m_sessions.erase(it);
+  }
+  return redirected;
+}
+
+bool Migration::started() const { return m_acceptor != nullptr; }
+
+void Migration::tick() {
+  auto now = m_gossip.clock().now();
+  for (auto it = m_inbound.begin(); it != m_inbound.end();) {
+    if (it->second.deadline > now) {
+      ++it;
+      continue;
+    }
+
+    BOOST_LOG_TRIVIAL(info) << "Migration::tick:"
+                            << "\t[partition]:" << it->first
+                            << "\t taken over without transfer";
+    it = m_inbound.erase(it);
+  }
+}
+
+void Migration::rebalance(const vector<Member::shared_ptr> &t_before,
+                          const vector<Member::shared_ptr> &t_after) {
+  if (!started())
+    return;
+
+  const auto &self = m_gossip.self_member();
+  const auto &memberlist = m_gossip.memberlist();
+  auto deadline = m_gossip.clock().now() + milliseconds(timeout());
+  auto redirected = m_redirect(t_after);
+
+  for (uint32_t partition = 0; partition < t_after.size(); ++partition) {
+    const auto &before = partition < t_before.size() ? t_before[partition] : self;
+    const auto &after = t_after[partition];
+    if (same(before, after) || redirected.contains(partition))
+      continue;
+
+    if (same(before, self)) {
+      m_outbound[partition] = Transfer{after, {}};
+      m_session(after)->enqueue(partition);
+    } else if (same(after, self)) {
+      bool alive = any_of(memberlist.begin(), memberlist.end(), [&before](const Member::shared_ptr &t_member) {
+        return same(t_member, before);
+      });
+      if (alive)
+        m_inbound[partition] = Source{before, deadline};
+    } else {
+      m_inbound.erase(partition);
+    }
+  }
+}
+
+Member::shared_ptr Migration::source(const uint32_t t_partition) const {
+  auto it = m_inbound.find(t_partition);
+  return it == m_inbound.end() ? nullptr : it->second.member;
+}
+
+bool Migration::outbound(const uint32_t t_partition) const { return m_outbound.contains(t_partition); }
+
+void Migration::record(const uint32_t t_partition, const string &t_key) {
+  auto it = m_outbound.find(t_partition);
+  if (it != m_outbound.end())
+    it->second.dirty.insert(t_key);
+}
+
+void Migration::send(const Member::shared_ptr t_target, const string &t_data) {
+  m_session(t_target)->send(encode(Frame::MESSAGE, 0, 0, t_data));
+}
+
+int32_t &Migration::chunk_size() { return m_chunk_size; }
+const int32_t &Migration::chunk_size() const { return m_chunk_size; }
+
+int32_t &Migration::window() { return m_window; }
+const int32_t &Migration::window() const { return m_window; }
+
+int32_t &Migration::rate() { return m_rate; }
+const int32_t &Migration::rate() const { return m_rate; }
+
+int32_t &Migration::timeout() { return m_timeout; }
+const int32_t &Migration::timeout() const { return m_timeout; }
+}; // namespace gossip
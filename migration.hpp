@@ -0,0 +1,112 @@
+#ifndef MIGRATION_HPP
+#define MIGRATION_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cache.hpp"
+#include "member.hpp"
+
+using boost::asio::ip::tcp;
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+namespace gossip {
+class Gossip;
+
+/**
+ * Moves partitions to their new owner over a dedicated TCP stream whenever the
+ * membership changes. The previous owner stays authoritative for a partition
+ * until the new owner acknowledges the commit frame; until then the new owner
+ * forwards reads and writes for it back to the previous owner.
+ *
+ * The same per-member stream also carries messages above `stream_threshold`.
+ */
+class Migration {
+  class Outbound;
+  class Inbound;
+
+  struct Source {
+    Member::shared_ptr member;
+    steady_clock::time_point deadline;
+  };
+
+  /** A partition being streamed away: where to, and the keys written since the scan passed them. */
+  struct Transfer {
+    Member::shared_ptr target;
+    set<string> dirty;
+  };
+
+  Gossip &m_gossip;
+  std::shared_ptr<tcp::acceptor> m_acceptor;
+  map<uint32_t, Source> m_inbound;
+  map<uint32_t, Transfer> m_outbound;
+  map<boost::uuids::uuid, std::shared_ptr<Outbound>> m_sessions;
+
+  int32_t m_chunk_size = 1 << 20;
+  int32_t m_window = 8;
+  int32_t m_rate = 64 << 20;
+  int32_t m_timeout = 30000;
+
+  void m_accept();
+  std::shared_ptr<Outbound> m_session(const Member::shared_ptr t_target);
+  set<uint32_t> m_redirect(const vector<Member::shared_ptr> &t_after);
+  string m_hello() const;
+
+public:
+  Migration(Gossip &t_gossip);
+
+  void start(const tcp::endpoint t_endpoint);
+
+  /** Whether `start` opened the TCP listener; without it ownership changes hand over without streaming. */
+  bool started() const;
+  void tick();
+
+  /**
+   * Diffs two ownership tables and starts or expects transfers for every
+   * partition that changed hands. Transfers already under way follow the new
+   * table: they move to the new owner, or stop if this member owns the
+   * partition again, and streams to members that left are closed.
+   */
+  void rebalance(const vector<Member::shared_ptr> &t_before,
+                 const vector<Member::shared_ptr> &t_after);
+
+  /** The previous owner of a partition that is still being streamed to us, or nullptr. */
+  Member::shared_ptr source(const uint32_t t_partition) const;
+
+  /** Whether a partition is being streamed away and is still served locally. */
+  bool outbound(const uint32_t t_partition) const;
+
+  /** Marks a key written while its partition is in transit so it is resent before the commit. */
+  void record(const uint32_t t_partition, const string &t_key);
+
+  /** Sends one serialized message to a member over its TCP stream. */
+  void send(const Member::shared_ptr t_target, const string &t_data);
+
+  /** The approximate number of payload bytes in one chunk frame. */
+  int32_t &chunk_size();
+  const int32_t &chunk_size() const;
+
+  /** The maximum number of unacknowledged chunks in flight per stream. */
+  int32_t &window();
+  const int32_t &window() const;
+
+  /** The outbound transfer budget in bytes per second per stream. */
+  int32_t &rate();
+  const int32_t &rate() const;
+
+  /** The time in milliseconds to wait for an expected transfer before taking the partition over empty. */
+  int32_t &timeout();
+  const int32_t &timeout() const;
+};
+}; // namespace gossip
+
+#endif
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+
+#include "pacer.hpp"
+
+using std::max;
+using std::min;
+using std::chrono::ceil;
+using std::chrono::duration;
+
+namespace gossip {
+namespace {
+
+// Every bucket holds at least one full datagram so a large message can always go out eventually.
+const double min_capacity = 65536;
+
+} // namespace
+
+void Pacer::Bucket::fill(const double t_rate, const double t_burst, const steady_clock::time_point t_now) {
+  if (refill == steady_clock::time_point{})
+    tokens = t_burst;
+  else
+    tokens = min(tokens + duration<double>(t_now - refill).count() * t_rate, t_burst);
+  refill = t_now;
+}
+
+Pacer::Peer &Pacer::m_peer(const udp::endpoint &t_peer) {
+  auto [it, inserted] = m_peers.try_emplace(t_peer);
+  if (inserted)
+    it->second.rate = std::clamp<double>(m_initial_rate, m_min_rate, m_max_rate);
+  return it->second;
+}
+
+double Pacer::m_capacity(const double t_rate) const {
+  return max(t_rate * m_burst / 1000, min_capacity);
+}
+
+bool Pacer::admit(const udp::endpoint &t_peer, const size_t t_bytes, const steady_clock::time_point t_now) {
+  Peer &peer = m_peer(t_peer);
+  peer.bytes.fill(peer.rate, m_capacity(peer.rate), t_now);
+  peer.packets.fill(m_packet_rate, max(m_packet_rate * m_burst / 1000.0, 1.0), t_now);
+  m_egress.fill(m_egress_rate, m_capacity(m_egress_rate), t_now);
+
+  double bytes = min<double>(t_bytes, min_capacity);
+  if (peer.bytes.tokens < bytes || peer.packets.tokens < 1 || m_egress.tokens < bytes)
+    return false;
+
+  peer.bytes.tokens -= bytes;
+  peer.packets.tokens -= 1;
+  m_egress.tokens -= bytes;
+  return true;
+}
+
+steady_clock::time_point Pacer::ready(const udp::endpoint &t_peer, const size_t t_bytes, const steady_clock::time_point t_now) {
+  Peer &peer = m_peer(t_peer);
+  double bytes = min<double>(t_bytes, min_capacity);
+  double wait = max({(bytes - peer.bytes.tokens) / peer.rate,
+                     (1 - peer.packets.tokens) / max(m_packet_rate, 1),
+                     (bytes - m_egress.tokens) / max(m_egress_rate, 1),
+                     0.0});
+  // Rounded up: a deficit shorter than one clock tick would otherwise wake at
+  // `t_now`, refill nothing and spin.
+  return t_now + ceil<steady_clock::duration>(duration<double>(wait));
+}
+
+void Pacer::loss(const udp::endpoint &t_peer) {
+  Peer &peer = m_peer(t_peer);
+  peer.rate = max<double>(peer.rate / 2, m_min_rate);
+}
+
+void Pacer::success(const udp::endpoint &t_peer) {
+  Peer &peer = m_peer(t_peer);
+  peer.rate = min<double>(peer.rate + m_increase, m_max_rate);
+}
+
+double Pacer::rate(const udp::endpoint &t_peer) { return m_peer(t_peer).rate; }
+void Pacer::forget(const udp::endpoint &t_peer) { m_peers.erase(t_peer); }
+
+int32_t &Pacer::initial_rate() { return m_initial_rate; }
+const int32_t &Pacer::initial_rate() const { return m_initial_rate; }
+
+int32_t &Pacer::min_rate() { return m_min_rate; }
+const int32_t &Pacer::min_rate() const { return m_min_rate; }
+
+int32_t &Pacer::max_rate() { return m_max_rate; }
+const int32_t &Pacer::max_rate() const { return m_max_rate; }
+
+int32_t &Pacer::increase() { return m_increase; }
+const int32_t &Pacer::increase() const { return m_increase; }
+
+int32_t &Pacer::packet_rate() { return m_packet_rate; }
+const int32_t &Pacer::packet_rate() const { return m_packet_rate; }
+
+int32_t &Pacer::egress_rate() { return m_egress_rate; }
+const int32_t &Pacer::egress_rate() const { return m_egress_rate; }
+
+int32_t &Pacer::burst() { return m_burst; }
+const int32_t &Pacer::burst() const { return m_burst; }
+
+}; // namespace gossip
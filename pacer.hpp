@@ -0,0 +1,97 @@
+#ifndef PACER_HPP
+#define PACER_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <map>
+
+using boost::asio::ip::udp;
+using std::map;
+using std::chrono::steady_clock;
+
+namespace gossip {
+
+/**
+ * Egress admission for datagrams. Every destination has a byte and a packet
+ * token bucket and all destinations share one global byte budget. A peer's
+ * byte rate follows AIMD: halved on every loss signal (a NACK or an
+ * unanswered probe) and raised by a fixed step on every acknowledged probe.
+ */
+class Pacer {
+  struct Bucket {
+    double tokens = 0;
+    steady_clock::time_point refill{};
+
+    void fill(const double t_rate, const double t_burst, const steady_clock::time_point t_now);
+  };
+
+  struct Peer {
+    double rate = 0;
+    Bucket bytes;
+    Bucket packets;
+  };
+
+  map<udp::endpoint, Peer> m_peers;
+  Bucket m_egress;
+
+  int32_t m_initial_rate = 16 << 20;
+  int32_t m_min_rate = 256 << 10;
+  int32_t m_max_rate = 128 << 20;
+  int32_t m_increase = 1 << 20;
+  int32_t m_packet_rate = 20000;
+  int32_t m_egress_rate = 256 << 20;
+  int32_t m_burst = 10;
+
+  Peer &m_peer(const udp::endpoint &t_peer);
+  double m_capacity(const double t_rate) const;
+
+public:
+  /** Takes the tokens for one datagram of `t_bytes` to a peer; false if any bucket is short. */
+  bool admit(const udp::endpoint &t_peer, const size_t t_bytes, const steady_clock::time_point t_now);
+
+  /** The earliest time at which `admit` can succeed for the same datagram. */
+  steady_clock::time_point ready(const udp::endpoint &t_peer, const size_t t_bytes, const steady_clock::time_point t_now);
+
+  /** Multiplicative decrease after a datagram to a peer was reported or presumed lost. */
+  void loss(const udp::endpoint &t_peer);
+
+  /** Additive increase after a peer acknowledged a round trip. */
+  void success(const udp::endpoint &t_peer);
+
+  /** The current byte rate allowed towards a peer. */
+  double rate(const udp::endpoint &t_peer);
+  void forget(const udp::endpoint &t_peer);
+
+  /** The byte rate per second a new peer starts at. */
+  int32_t &initial_rate();
+  const int32_t &initial_rate() const;
+
+  /** The byte rate per second a peer never drops below. */
+  int32_t &min_rate();
+  const int32_t &min_rate() const;
+
+  /** The byte rate per second a peer never exceeds. */
+  int32_t &max_rate();
+  const int32_t &max_rate() const;
+
+  /** The byte rate per second added to a peer for every acknowledged round trip. */
+  int32_t &increase();
+  const int32_t &increase() const;
+
+  /** The datagrams per second allowed towards one peer. */
+  int32_t &packet_rate();
+  const int32_t &packet_rate() const;
+
+  /** The byte rate per second allowed across all peers together. */
+  int32_t &egress_rate();
+  const int32_t &egress_rate() const;
+
+  /** The burst every bucket allows, in milliseconds of its rate. */
+  int32_t &burst();
+  const int32_t &burst() const;
+};
+
+}; // namespace gossip
+
+#endif
@@ -0,0 +1,296 @@
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/program_options.hpp>
+#include <boost/uuid/random_generator.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gossip.hpp"
+#include "simulator.hpp"
+
+using boost::asio::ip::address_v4;
+using boost::asio::ip::udp;
+using boost::program_options::error;
+using boost::program_options::notify;
+using boost::program_options::options_description;
+using boost::program_options::parse_command_line;
+using boost::program_options::store;
+using boost::program_options::value;
+using boost::program_options::variables_map;
+using boost::uuids::basic_random_generator;
+using gossip::Gossip;
+using gossip::Member;
+using gossip::Network;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::make_unique;
+using std::map;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+  uint32_t nodes = 1000;
+  uint64_t seed = 1;
+  int32_t latency = 5;
+  int32_t jitter = 5;
+  double loss = 0;
+  uint32_t crash = 10;
+  double partition = 0;
+  int32_t partition_time = 5000;
+  int32_t duration = 60000;
+  int32_t step = 10;
+};
+
+struct Node {
+  unique_ptr<Gossip> gossip;
+  steady_clock::time_point scheduled;
+  uint64_t ticks = 0;
+};
+
+/** Counts what the membership listeners observe across the whole cluster. */
+struct Census {
+  int64_t known = 0;
+  int64_t stale = 0;
+  uint64_t false_positives = 0;
+  uint64_t partitioned = 0;
+  uint64_t detected = 0;
+};
+
+bool parse_args(int argc, char *argv[], Options &options) {
+  options_description description("Cache Cluster Simulator");
+  description.add_options()
+      .
+      operator()("help", "Prints this message")
+      .
+      operator()("nodes,n",
+                 value(&options.nodes)->default_value(options.nodes),
+                 "The number of simulated members")
+      .
+      operator()("seed",
+                 value(&options.seed)->default_value(options.seed),
+                 "The seed of every random choice in the run")
+      .
+      operator()("latency",
+                 value(&options.latency)->default_value(options.latency),
+                 "The one-way delay in milliseconds")
+      .
+      operator()("jitter",
+                 value(&options.jitter)->default_value(options.jitter),
+                 "The uniform extra delay in milliseconds")
+      .
+      operator()("loss",
+                 value(&options.loss)->default_value(options.loss),
+                 "The probability that a datagram is lost")
+      .
+      operator()("crash",
+                 value(&options.crash)->default_value(options.crash),
+                 "The number of members crashed after convergence")
+      .
+      operator()("partition",
+                 value(&options.partition)->default_value(options.partition),
+                 "The fraction of members cut off from the rest after the crashes")
+      .
+      operator()("partition-time",
+                 value(&options.partition_time)->default_value(options.partition_time),
+                 "How long in milliseconds the partition lasts")
+      .
+      operator()("duration",
+                 value(&options.duration)->default_value(options.duration),
+                 "The longest each phase may run in virtual milliseconds");
+
+  variables_map args;
+  try {
+    store(parse_command_line(argc, argv, description), args);
+    notify(args);
+  } catch (error e) {
+    cerr << e.what() << endl;
+    return false;
+  }
+
+  if (args.count("help")) {
+    cout << description << endl;
+    return false;
+  }
+
+  return options.nodes >= 2;
+}
+
+double elapsed(const steady_clock::time_point t_since, const steady_clock::time_point t_until) {
+  return duration_cast<milliseconds>(t_until - t_since).count();
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parse_args(argc, argv, options))
+    return 1;
+
+  boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+  Network network(options.seed);
+  network.latency() = options.latency;
+  network.jitter() = options.jitter;
+  network.loss() = options.loss;
+
+  std::mt19937 random(options.seed);
+  basic_random_generator<std::mt19937> uids(random);
+
+  vector<Node> nodes(options.nodes);
+  map<udp::endpoint, size_t> index;
+  vector<Member> members;
+  Census census;
+
+  auto plan = [&](const size_t t_node) {
+    Node &node = nodes[t_node];
+    auto at = node.gossip->next_tick();
+    if (node.scheduled != steady_clock::time_point{} && node.scheduled <= at)
+      return;
+
+    node.scheduled = at;
+    network.schedule(members[t_node].address(), at, [&nodes, t_node, at]() {
+      Node &node = nodes[t_node];
+      if (node.scheduled != at)
+        return;
+      node.scheduled = {};
+      node.gossip->tick();
+      ++node.ticks;
+    });
+  };
+
+  network.after() = [&](const udp::endpoint &t_node) {
+    auto &context = nodes[index[t_node]].gossip->context();
+    if (context.stopped())
+      context.restart();
+    context.poll();
+    plan(index[t_node]);
+  };
+
+  for (uint32_t i = 0; i < options.nodes; ++i) {
+    udp::endpoint address(address_v4(0x0a000001 + i), 7777);
+    members.emplace_back(uids(), address);
+    index[address] = i;
+  }
+
+  for (uint32_t i = 0; i < options.nodes; ++i) {
+    auto &address = members[i].address();
+    auto &gossip = nodes[i].gossip;
+    gossip = make_unique<Gossip>(members[i], [](string) {}, network.transport(address), network.clock(address));
+    gossip->seed(options.seed + i);
+    gossip->membership_listener() = [&, address](const Member::shared_ptr t_member, const bool t_joined) {
+      bool crashed = network.crashed(t_member->address());
+      if (t_joined) {
+        ++census.known;
+        census.stale += crashed;
+        return;
+      }
+
+      --census.known;
+      if (crashed) {
+        --census.stale;
+        ++census.detected;
+      } else if (network.reachable(address, t_member->address())) {
+        ++census.false_positives;
+      } else {
+        ++census.partitioned;
+      }
+    };
+    gossip->add_member(members[i == 0 ? 1 : 0]);
+    plan(i);
+  }
+
+  auto run = [&](const std::function<bool()> t_done) {
+    auto deadline = network.now() + milliseconds(options.duration);
+    while (!t_done() && network.now() < deadline)
+      network.run_until(network.now() + milliseconds(options.step));
+    return t_done();
+  };
+  auto bytes = [&]() {
+    uint64_t total = 0;
+    for (auto &member : members)
+      total += network.bytes(member.address());
+    return total;
+  };
+  auto ticks = [&]() {
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < options.nodes; ++i)
+      total += network.crashed(members[i].address()) ? 0 : nodes[i].ticks;
+    return total;
+  };
+
+  int64_t everyone = (int64_t)options.nodes * (options.nodes - 1);
+  auto start = network.now();
+  bool converged = run([&]() { return census.known == everyone; });
+  uint64_t join_bytes = bytes();
+  cout << "nodes: " << options.nodes << endl;
+  cout << "seed: " << options.seed << endl;
+  cout << "converged: " << (converged ? "yes" : "no") << " (" << census.known << "/" << everyone << ")" << endl;
+  cout << "convergence_ms: " << elapsed(start, network.now()) << endl;
+  cout << "convergence_rounds: " << (double)ticks() / options.nodes << endl;
+  cout << "join_bytes_per_node: " << join_bytes / options.nodes << endl;
+
+  uint32_t crash = std::min(options.crash, options.nodes - 2);
+  vector<size_t> order(options.nodes);
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::shuffle(order.begin() + 1, order.end(), random);
+
+  // Every live member that still lists a crashed one has a detection ahead of it.
+  for (uint32_t i = 0; i < crash; ++i)
+    network.crash(members[order[order.size() - 1 - i]].address());
+  census.stale = 0;
+  for (uint32_t i = 0; i < options.nodes; ++i) {
+    if (network.crashed(members[i].address()))
+      continue;
+    for (auto &member : nodes[i].gossip->memberlist())
+      census.stale += network.crashed(member->address());
+  }
+
+  start = network.now();
+  uint64_t rounds = ticks();
+  bool detected = run([&]() { return census.stale == 0; });
+  cout << "crashed: " << crash << endl;
+  cout << "detected: " << (detected ? "yes" : "no") << " (" << census.detected << " removals, " << census.stale
+       << " outstanding)" << endl;
+  cout << "detection_ms: " << elapsed(start, network.now()) << endl;
+  cout << "detection_rounds: " << (double)(ticks() - rounds) / (options.nodes - crash) << endl;
+
+  if (options.partition > 0) {
+    std::set<udp::endpoint> side;
+    for (uint32_t i = 0; i < options.nodes * options.partition; ++i)
+      side.insert(members[order[i]].address());
+    network.partition(side);
+    network.run_until(network.now() + milliseconds(options.partition_time));
+    network.heal();
+    cout << "partition_removals: " << census.partitioned << endl;
+  }
+
+  network.run_until(network.now() + milliseconds(options.step));
+  cout << "false_positives: " << census.false_positives << endl;
+  cout << "false_positive_rate: " << (double)census.false_positives / everyone << endl;
+  cout << "bytes_per_node: " << bytes() / options.nodes << endl;
+  cout << "datagrams_dropped: " << network.dropped() << endl;
+
+  uint64_t digest = 0;
+  for (auto &node : nodes)
+    digest = digest * 1099511628211ull ^ node.gossip->membership_digest();
+  cout << "digest: " << std::hex << digest << std::dec << endl;
+
+  return 0;
+}
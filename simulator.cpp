@@ -0,0 +1,151 @@
+#include <chrono>
+#include <memory>
+#include <random>
+
+#include "simulator.hpp"
+
+using std::make_shared;
+using std::chrono::milliseconds;
+
+namespace gossip {
+
+class Network::Port : public Transport {
+  Network &m_network;
+  udp::endpoint m_address;
+
+public:
+  Port(Network &t_network, const udp::endpoint t_address) : m_network(t_network), m_address(t_address) {}
+
+  virtual void receive(const ReceiveFn t_receive) override { m_network.m_nodes[m_address].receive = t_receive; }
+
+  virtual void send(const udp::endpoint &t_destination, const shared_ptr<string> t_data) override {
+    m_network.m_send(m_address, t_destination, t_data);
+  }
+};
+
+class Network::Timer : public Clock {
+  Network &m_network;
+  udp::endpoint m_address;
+
+public:
+  Timer(Network &t_network, const udp::endpoint t_address) : m_network(t_network), m_address(t_address) {}
+
+  virtual steady_clock::time_point now() const override { return m_network.now(); }
+
+  virtual void schedule(const steady_clock::time_point t_at, const TimerFn t_callback) override {
+    m_network.schedule(m_address, t_at, t_callback);
+  }
+};
+
+bool Network::Event::operator>(const Event &t_other) const {
+  return at != t_other.at ? at > t_other.at : sequence > t_other.sequence;
+}
+
+Network::Network(const uint64_t t_seed) : m_random(t_seed) {}
+
+shared_ptr<Transport> Network::transport(const udp::endpoint &t_address) {
+  m_nodes[t_address];
+  return make_shared<Port>(*this, t_address);
+}
+
+shared_ptr<Clock> Network::clock(const udp::endpoint &t_address) {
+  m_nodes[t_address];
+  return make_shared<Timer>(*this, t_address);
+}
+
+void Network::schedule(const udp::endpoint &t_node, const steady_clock::time_point t_at, const EventFn t_event) {
+  m_events.push(Event{std::max(t_at, m_now), ++m_sequence, t_node, t_event});
+}
+
+void Network::m_send(const udp::endpoint &t_source, const udp::endpoint &t_destination, const shared_ptr<string> t_data) {
+  Node &source = m_nodes[t_source];
+  if (source.crashed)
+    return;
+
+  source.bytes += t_data->size();
+  ++source.datagrams;
+
+  std::uniform_real_distribution<double> chance(0, 1);
+  if (!reachable(t_source, t_destination) || chance(m_random) < m_loss) {
+    ++m_dropped;
+    return;
+  }
+
+  std::uniform_int_distribution<int32_t> jitter(0, std::max(m_jitter, 0));
+  auto at = m_now + milliseconds(m_latency + jitter(m_random));
+  schedule(t_destination, at, [this, t_source, t_destination, t_data]() {
+    auto node = m_nodes.find(t_destination);
+    if (node == m_nodes.end() || !node->second.receive || !reachable(t_source, t_destination)) {
+      ++m_dropped;
+      return;
+    }
+    node->second.receive(t_source, *t_data);
+  });
+}
+
+void Network::run_until(const steady_clock::time_point t_until) {
+  while (!m_events.empty() && m_events.top().at <= t_until) {
+    Event event = m_events.top();
+    m_events.pop();
+    m_now = event.at;
+    if (crashed(event.node))
+      continue;
+
+    event.run();
+    if (m_after)
+      m_after(event.node);
+  }
+  m_now = std::max(m_now, t_until);
+}
+
+steady_clock::time_point Network::now() const { return m_now; }
+
+void Network::crash(const udp::endpoint &t_node) { m_nodes[t_node].crashed = true; }
+
+bool Network::crashed(const udp::endpoint &t_node) const {
+  auto node = m_nodes.find(t_node);
+  return node != m_nodes.end() && node->second.crashed;
+}
+
+void Network::partition(const set<udp::endpoint> &t_side) {
+  for (auto &[address, node] : m_nodes)
+    node.side = t_side.contains(address) ? 1 : 0;
+}
+
+void Network::heal() {
+  for (auto &[address, node] : m_nodes)
+    node.side = 0;
+}
+
+bool Network::reachable(const udp::endpoint &t_source, const udp::endpoint &t_destination) const {
+  auto source = m_nodes.find(t_source);
+  auto destination = m_nodes.find(t_destination);
+  if (source == m_nodes.end() || destination == m_nodes.end())
+    return false;
+  return !source->second.crashed && !destination->second.crashed && source->second.side == destination->second.side;
+}
+
+Network::AfterFn &Network::after() { return m_after; }
+
+uint64_t Network::bytes(const udp::endpoint &t_node) const {
+  auto node = m_nodes.find(t_node);
+  return node == m_nodes.end() ? 0 : node->second.bytes;
+}
+
+uint64_t Network::datagrams(const udp::endpoint &t_node) const {
+  auto node = m_nodes.find(t_node);
+  return node == m_nodes.end() ? 0 : node->second.datagrams;
+}
+
+uint64_t Network::dropped() const { return m_dropped; }
+
+int32_t &Network::latency() { return m_latency; }
+const int32_t &Network::latency() const { return m_latency; }
+
+int32_t &Network::jitter() { return m_jitter; }
+const int32_t &Network::jitter() const { return m_jitter; }
+
+double &Network::loss() { return m_loss; }
+const double &Network::loss() const { return m_loss; }
+
+}; // namespace gossip
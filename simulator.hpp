@@ -0,0 +1,124 @@
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "clock.hpp"
+#include "transport.hpp"
+
+using boost::asio::ip::udp;
+using std::map;
+using std::set;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+namespace gossip {
+
+/**
+ * An in-memory datagram network under virtual time. Every datagram and timer
+ * becomes an event ordered by (time, insertion), and latency, jitter and loss
+ * come from one seeded generator, so a run is reproducible from its seed.
+ * Nodes can crash and the network can be split into unreachable sides.
+ */
+class Network {
+public:
+  typedef std::function<void()> EventFn;
+  typedef std::function<void(const udp::endpoint &)> AfterFn;
+
+private:
+  class Port;
+  class Timer;
+
+  struct Event {
+    steady_clock::time_point at;
+    uint64_t sequence;
+    udp::endpoint node;
+    EventFn run;
+
+    bool operator>(const Event &t_other) const;
+  };
+
+  struct Node {
+    Transport::ReceiveFn receive;
+    bool crashed = false;
+    uint32_t side = 0;
+    uint64_t bytes = 0;
+    uint64_t datagrams = 0;
+  };
+
+  steady_clock::time_point m_now{std::chrono::hours(1)};
+  uint64_t m_sequence = 0;
+  std::priority_queue<Event, vector<Event>, std::greater<Event>> m_events;
+  map<udp::endpoint, Node> m_nodes;
+  std::mt19937_64 m_random;
+  AfterFn m_after;
+  uint64_t m_dropped = 0;
+
+  int32_t m_latency = 5;
+  int32_t m_jitter = 5;
+  double m_loss = 0;
+
+  void m_send(const udp::endpoint &t_source, const udp::endpoint &t_destination, const shared_ptr<string> t_data);
+
+public:
+  Network(const uint64_t t_seed);
+
+  /** The transport of the node at `t_address`. */
+  shared_ptr<Transport> transport(const udp::endpoint &t_address);
+
+  /** The virtual clock of the node at `t_address`; its timers run as that node's events. */
+  shared_ptr<Clock> clock(const udp::endpoint &t_address);
+
+  void schedule(const udp::endpoint &t_node, const steady_clock::time_point t_at, const EventFn t_event);
+
+  /** Processes every event due up to `t_until` and advances virtual time to it. */
+  void run_until(const steady_clock::time_point t_until);
+  steady_clock::time_point now() const;
+
+  /** Silences a node: it stops sending, receiving and firing timers. */
+  void crash(const udp::endpoint &t_node);
+  bool crashed(const udp::endpoint &t_node) const;
+
+  /** Cuts every node in `t_side` off from the rest until `heal`. */
+  void partition(const set<udp::endpoint> &t_side);
+  void heal();
+  bool reachable(const udp::endpoint &t_source, const udp::endpoint &t_destination) const;
+
+  /** Called with the node after each of its events, e.g. to drain its io_context. */
+  AfterFn &after();
+
+  /** The bytes and datagrams a node has sent so far. */
+  uint64_t bytes(const udp::endpoint &t_node) const;
+  uint64_t datagrams(const udp::endpoint &t_node) const;
+
+  /** The datagrams lost to `loss`, partitions or crashed nodes. */
+  uint64_t dropped() const;
+
+  /** The base one-way delay in milliseconds. */
+  int32_t &latency();
+  const int32_t &latency() const;
+
+  /** The uniform extra delay in milliseconds added on top of `latency`. */
+  int32_t &jitter();
+  const int32_t &jitter() const;
+
+  /** The probability that a datagram is lost. */
+  double &loss();
+  const double &loss() const;
+};
+
+}; // namespace gossip
+
+#endif
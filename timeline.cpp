@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "trace.hpp"
+
+using boost::asio::ip::address_v4;
+using boost::program_options::error;
+using boost::program_options::notify;
+using boost::program_options::options_description;
+using boost::program_options::parse_command_line;
+using boost::program_options::positional_options_description;
+using boost::program_options::store;
+using boost::program_options::value;
+using boost::program_options::variables_map;
+using gossip::Event;
+using gossip::Trace;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::string;
+using std::vector;
+
+namespace {
+
+struct Options {
+  string input;
+  string event;
+  uint32_t thread = UINT32_MAX;
+  uint32_t last = 0;
+};
+
+bool parse_args(int argc, char *argv[], Options &options) {
+  options_description description("Cache Cluster Trace Decoder");
+  description.add_options()
+      .
+      operator()("help", "Prints this message")
+      .
+      operator()("input,i",
+                 value(&options.input)->value_name("[path]"),
+                 "The dump written by Trace::dump")
+      .
+      operator()("event,e",
+                 value(&options.event)->value_name("[name]"),
+                 "Only records of this event, e.g. SUSPECT")
+      .
+      operator()("thread,t",
+                 value(&options.thread)->value_name("[index]"),
+                 "Only records of this recording thread")
+      .
+      operator()("last,l",
+                 value(&options.last)->value_name("[count]"),
+                 "Only the newest records");
+
+  positional_options_description positional;
+  positional.add("input", 1);
+
+  variables_map args;
+  try {
+    store(boost::program_options::command_line_parser(argc, argv).options(description).positional(positional).run(), args);
+    notify(args);
+  } catch (const error &e) {
+    cerr << e.what() << endl;
+    return false;
+  }
+
+  if (args.count("help") || options.input.empty()) {
+    cout << description << endl;
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parse_args(argc, argv, options))
+    return 1;
+
+  ifstream in(options.input, std::ios::binary);
+  Trace::Header header{};
+  if (!in.read((char *)&header, sizeof(header)) || std::memcmp(header.magic, Trace::magic, sizeof(Trace::magic)) ||
+      header.record_size != sizeof(Trace::Record)) {
+    cerr << options.input << ": not a trace dump" << endl;
+    return 1;
+  }
+
+  vector<array<char, Trace::name_size>> names(header.names);
+  in.read((char *)names.data(), names.size() * Trace::name_size);
+  for (auto &name : names)
+    name.back() = '\0';
+
+  vector<Trace::Record> records;
+  for (uint32_t i = 0; in && i < header.rings; ++i) {
+    Trace::Chunk chunk{};
+    if (!in.read((char *)&chunk, sizeof(chunk)))
+      break;
+    auto offset = records.size();
+    records.resize(offset + chunk.count);
+    in.read((char *)&records[offset], chunk.count * sizeof(Trace::Record));
+  }
+  if (!in) {
+    cerr << options.input << ": truncated, decoding what was read" << endl;
+    // A partially read chunk leaves zeroed records at the end; drop them.
+    while (!records.empty() && !records.back().time)
+      records.pop_back();
+  }
+
+  std::stable_sort(records.begin(), records.end(),
+                   [](const Trace::Record &a, const Trace::Record &b) { return a.time < b.time; });
+  std::erase_if(records, [&options](const Trace::Record &record) {
+    return (!options.event.empty() && options.event != Trace::name((Event)record.event)) ||
+           (options.thread != UINT32_MAX && options.thread != record.thread);
+  });
+  if (options.last && records.size() > options.last)
+    records.erase(records.begin(), records.end() - options.last);
+
+  // Times are offsets from the dump, which is usually when things went wrong.
+  std::time_t dumped = header.system / 1000000000;
+  cout << "dumped at " << std::put_time(std::gmtime(&dumped), "%FT%TZ") << ", " << records.size() << " records" << endl;
+  for (const auto &record : records) {
+    auto ago = (double)((int64_t)header.steady - (int64_t)record.time) / 1e6;
+    uuid peer;
+    std::memcpy(peer.data, record.peer.data(), record.peer.size());
+
+    cout << std::fixed << std::setprecision(3) << std::setw(12) << -ago << "ms"
+         << "\t[thread]:" << record.thread
+         << "\t" << std::left << std::setw(10) << Trace::name((Event)record.event) << std::right
+         << "\t[peer]:" << address_v4(record.address) << ":" << record.port;
+    if (!peer.is_nil())
+      cout << " " << peer;
+
+    switch ((Event)record.event) {
+      case Event::STATE:
+        cout << "\t[state]:" << record.sequence << " -> " << record.detail;
+        break;
+      case Event::SUSPECT:
+      case Event::FAIL:
+        cout << "\t[failures]:" << record.detail;
+        break;
+      case Event::JOIN:
+      case Event::LEAVE:
+        cout << "\t[members]:" << record.size;
+        break;
+      default:
+        cout << "\t[sequence]:" << record.sequence << "\t[size]:" << record.size;
+        if (record.detail && record.detail <= names.size())
+          cout << "\t" << names[record.detail - 1].data();
+    }
+    cout << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+
+#include "trace.hpp"
+
+using std::lock_guard;
+using std::mutex;
+using std::string;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
+
+namespace gossip {
+namespace {
+
+struct Ring {
+  atomic<uint64_t> head{0};
+  uint32_t thread = 0;
+  array<Trace::Record, Trace::ring_capacity> records{};
+};
+
+// Rings are never freed: a thread that has exited may still hold the events a
+// post-mortem needs, and the handler must not race a destructor.
+array<atomic<Ring *>, Trace::max_rings> rings{};
+atomic<uint32_t> ring_count{0};
+
+array<array<char, Trace::name_size>, Trace::max_names> names{};
+atomic<uint32_t> name_count{0};
+mutex names_mutex;
+
+char crash_path[4096];
+
+Ring *ring() {
+  thread_local Ring *mine = []() -> Ring * {
+    uint32_t index = ring_count.fetch_add(1, std::memory_order_relaxed);
+    if (index >= Trace::max_rings)
+      return nullptr;
+    auto ring = new Ring();
+    ring->thread = index;
+    rings[index].store(ring, std::memory_order_release);
+    return ring;
+  }();
+  return mine;
+}
+
+bool write_all(const int t_fd, const void *t_data, size_t t_size) {
+  auto data = (const char *)t_data;
+  while (t_size) {
+    auto written = ::write(t_fd, data, t_size);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    data += written;
+    t_size -= written;
+  }
+  return true;
+}
+
+void on_crash(const int t_signal) {
+  Trace::dump(crash_path);
+  std::signal(t_signal, SIG_DFL);
+  std::raise(t_signal);
+}
+
+} // namespace
+
+void Trace::record(const Event t_event,
+                   const udp::endpoint &t_peer,
+                   const uuid &t_uid,
+                   const uint32_t t_sequence,
+                   const uint32_t t_size,
+                   const uint32_t t_detail) {
+  auto mine = ring();
+  if (!mine)
+    return;
+
+  auto head = mine->head.load(std::memory_order_relaxed);
+  auto &record = mine->records[head % ring_capacity];
+  record.time = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  std::memcpy(record.peer.data(), t_uid.data, record.peer.size());
+  record.address = t_peer.address().is_v4() ? t_peer.address().to_v4().to_uint() : 0;
+  record.port = t_peer.port();
+  record.event = (uint16_t)t_event;
+  record.sequence = t_sequence;
+  record.size = t_size;
+  record.detail = t_detail;
+  record.thread = mine->thread;
+  mine->head.store(head + 1, std::memory_order_release);
+}
+
+uint32_t Trace::intern(const string &t_name) {
+  lock_guard<mutex> lock(names_mutex);
+  uint32_t count = name_count.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < count; ++i)
+    if (t_name.compare(0, name_size - 1, names[i].data()) == 0)
+      return i + 1;
+
+  // Zero means no name, so ids start at one; past the table every name shares the last slot.
+  if (count == max_names)
+    return max_names;
+  t_name.copy(names[count].data(), name_size - 1);
+  name_count.store(count + 1, std::memory_order_release);
+  return count + 1;
+}
+
+bool Trace::dump(const char *t_path) {
+  int fd = ::open(t_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+
+  uint32_t count = std::min<uint32_t>(ring_count.load(std::memory_order_acquire), (uint32_t)max_rings);
+  Header header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = 1;
+  header.record_size = sizeof(Record);
+  header.steady = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+  header.system = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+  header.names = max_names;
+  header.rings = count;
+
+  bool ok = write_all(fd, &header, sizeof(header)) && write_all(fd, names.data(), sizeof(names));
+  for (uint32_t i = 0; ok && i < count; ++i) {
+    // A ring claimed but not yet published is written empty so the chunk count stays right.
+    auto ring = rings[i].load(std::memory_order_acquire);
+    uint64_t head = ring ? ring->head.load(std::memory_order_acquire) : 0;
+    uint64_t size = std::min<uint64_t>(head, ring_capacity);
+    Chunk chunk{i, (uint32_t)size};
+    ok = write_all(fd, &chunk, sizeof(chunk));
+
+    uint64_t start = (head - size) % ring_capacity;
+    uint64_t first = std::min<uint64_t>(size, ring_capacity - start);
+    if (ok && size)
+      ok = write_all(fd, &ring->records[start], first * sizeof(Record)) &&
+           write_all(fd, &ring->records[0], (size - first) * sizeof(Record));
+  }
+
+  ::close(fd);
+  return ok;
+}
+
+void Trace::dump_on_crash(const string &t_path) {
+  crash_path[t_path.copy(crash_path, sizeof(crash_path) - 1)] = '\0';
+  for (int signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT})
+    std::signal(signal, on_crash);
+}
+
+const char *Trace::name(const Event t_event) {
+  switch (t_event) {
+    case Event::STATE:
+      return "STATE";
+    case Event::JOIN:
+      return "JOIN";
+    case Event::LEAVE:
+      return "LEAVE";
+    case Event::SUSPECT:
+      return "SUSPECT";
+    case Event::FAIL:
+      return "FAIL";
+    case Event::PROBE:
+      return "PROBE";
+    case Event::ACK:
+      return "ACK";
+    case Event::SEND:
+      return "SEND";
+    case Event::RECEIVE:
+      return "RECEIVE";
+    case Event::DROP:
+      return "DROP";
+    case Event::INVALID:
+      return "INVALID";
+    case Event::RETRANSMIT:
+      return "RETRANSMIT";
+  }
+  return "UNKNOWN";
+}
+
+}; // namespace gossip
@@ -0,0 +1,108 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <array>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <cstdint>
+#include <string>
+
+using boost::asio::ip::udp;
+using boost::uuids::uuid;
+using std::array;
+using std::atomic;
+using std::string;
+
+namespace gossip {
+
+/**
+ * What a trace record describes. Packet events carry the message sequence and
+ * the interned type name in `detail`; STATE carries the old State as sequence
+ * and the new one as detail; SUSPECT and FAIL carry the failed probe count.
+ */
+enum class Event : uint16_t {
+  STATE = 0,
+  JOIN = 1,
+  LEAVE = 2,
+  SUSPECT = 3,
+  FAIL = 4,
+  PROBE = 5,
+  ACK = 6,
+  SEND = 7,
+  RECEIVE = 8,
+  DROP = 9,
+  INVALID = 10,
+  RETRANSMIT = 11
+};
+
+/**
+ * An always-on flight recorder. Each thread appends fixed-size binary records
+ * to its own ring, so recording is a clock read and a copy with no lock and no
+ * formatting; the oldest records are overwritten. `dump` writes every ring to a
+ * file using only async-signal-safe calls, which is what lets a crash handler
+ * leave a post-mortem behind. `cache-cluster-trace` turns a dump into a timeline.
+ *
+ * A dump taken while other threads record may contain a few torn records at
+ * the ring heads; the recorder trades that for never blocking a writer.
+ */
+class Trace {
+public:
+  static const uint32_t ring_capacity = 1 << 13;
+  static const uint32_t max_rings = 256;
+  static const uint32_t max_names = 64;
+  static const uint32_t name_size = 32;
+
+  struct Record {
+    uint64_t time;           // steady clock, nanoseconds
+    array<uint8_t, 16> peer; // uid, nil when only the address is known
+    uint32_t address;        // IPv4 address in host order, 0 for IPv6
+    uint16_t port;
+    uint16_t event;
+    uint32_t sequence;
+    uint32_t size;
+    uint32_t detail; // see `Event`
+    uint32_t thread;
+  };
+  static_assert(sizeof(Record) == 48);
+
+  /** Starts a dump; followed by the name table, then per ring a `Chunk` and its records oldest first. */
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t steady; // the clocks at dump time, to place records in wall-clock time
+    uint64_t system;
+    uint32_t names;
+    uint32_t rings;
+  };
+
+  struct Chunk {
+    uint32_t thread;
+    uint32_t count;
+  };
+
+  static constexpr char magic[8] = {'G', 'S', 'T', 'R', 'A', 'C', 'E', '1'};
+
+  static void record(const Event t_event,
+                     const udp::endpoint &t_peer,
+                     const uuid &t_uid,
+                     const uint32_t t_sequence,
+                     const uint32_t t_size,
+                     const uint32_t t_detail = 0);
+
+  /** An id for `t_name` to put in `Record::detail`; the name travels in the dump. Meant for a handful of type names. */
+  static uint32_t intern(const string &t_name);
+
+  /** Writes every ring to `t_path`; safe to call from a signal handler. */
+  static bool dump(const char *t_path);
+
+  /** Dumps to `t_path` when the process dies of SIGSEGV, SIGBUS, SIGFPE, SIGILL or SIGABRT. */
+  static void dump_on_crash(const string &t_path);
+
+  static const char *name(const Event t_event);
+};
+
+}; // namespace gossip
+
+#endif
@@ -0,0 +1,59 @@
+#include <boost/asio.hpp>
+#include <boost/log/trivial.hpp>
+#include <string>
+
+#include "transport.hpp"
+
+using boost::asio::buffer;
+using boost::asio::dynamic_buffer;
+using boost::system::error_code;
+
+namespace gossip {
+namespace {
+
+const size_t max_datagram_size = 65535;
+
+} // namespace
+
+UdpTransport::UdpTransport(io_context &t_context, const udp::endpoint t_address) : m_socket(t_context, t_address) {
+  error_code ignored;
+  m_socket.set_option(udp::socket::receive_buffer_size(4 << 20), ignored);
+  m_socket.set_option(udp::socket::send_buffer_size(4 << 20), ignored);
+}
+
+void UdpTransport::receive(const ReceiveFn t_receive) {
+  m_receive = t_receive;
+  if (m_receiving)
+    return;
+
+  m_receiving = true;
+  m_buffer.clear();
+  auto self = shared_from_this();
+  m_socket.async_receive_from(
+      dynamic_buffer(m_buffer).prepare(max_datagram_size),
+      m_sender,
+      [self](const error_code ec, const size_t length) {
+        self->m_receiving = false;
+        if (ec) {
+          BOOST_LOG_TRIVIAL(error) << "UdpTransport::receive:"
+                                   << "\t[address]:" << ec.message();
+
+          return;
+        }
+
+        self->m_receive(self->m_sender, self->m_buffer.substr(0, length));
+        self->receive(self->m_receive);
+      });
+}
+
+void UdpTransport::send(const udp::endpoint &t_destination, const shared_ptr<string> t_data) {
+  m_socket.async_send_to(
+      buffer(*t_data),
+      t_destination,
+      [t_data](const error_code ec, const size_t length) {
+        if (ec)
+          return;
+      });
+}
+
+}; // namespace gossip
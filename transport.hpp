@@ -0,0 +1,48 @@
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#include <boost/asio.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+
+using boost::asio::io_context;
+using boost::asio::ip::udp;
+using std::shared_ptr;
+using std::string;
+
+namespace gossip {
+
+/** The datagram path of a Gossip node: a UDP socket in production, an in-memory network in simulations. */
+class Transport {
+public:
+  typedef std::function<void(const udp::endpoint &, const string &)> ReceiveFn;
+
+  virtual ~Transport() = default;
+
+  /** Delivers inbound datagrams to `t_receive` until an error; calling it again resumes receiving. */
+  virtual void receive(const ReceiveFn t_receive) = 0;
+
+  virtual void send(const udp::endpoint &t_destination, const shared_ptr<string> t_data) = 0;
+
+  /** Whether a destination is on this host and bypasses the network, so pacing does not apply to it. */
+  virtual bool local(const udp::endpoint &t_destination) const { return false; }
+};
+
+class UdpTransport : public Transport, public std::enable_shared_from_this<UdpTransport> {
+  udp::socket m_socket;
+  string m_buffer;
+  udp::endpoint m_sender;
+  ReceiveFn m_receive;
+  bool m_receiving = false;
+
+public:
+  UdpTransport(io_context &t_context, const udp::endpoint t_address);
+
+  virtual void receive(const ReceiveFn t_receive) override;
+  virtual void send(const udp::endpoint &t_destination, const shared_ptr<string> t_data) override;
+};
+
+}; // namespace gossip
+
+#endif